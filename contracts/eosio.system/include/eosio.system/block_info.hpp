@@ -2,6 +2,7 @@
 
 #include <eosio/multi_index.hpp>
 #include <eosio/name.hpp>
+#include <eosio/singleton.hpp>
 #include <eosio/time.hpp>
 
 #include <limits>
@@ -11,6 +12,10 @@ namespace eosiosystem::block_info {
 
 static constexpr uint32_t rolling_window_size = 10;
 
+// TELOS BEGIN
+static constexpr uint32_t max_rolling_window_size = 7200; // one hour of blocks
+// TELOS END
+
 /**
  * The blockinfo table holds a rolling window of records containing information for recent blocks.
  *
@@ -33,6 +38,183 @@ struct [[eosio::table, eosio::contract("eosio.system")]] block_info_record
 
 using block_info_table = eosio::multi_index<"blockinfo"_n, block_info_record>;
 
+// TELOS BEGIN
+/**
+ * The blockwindow singleton holds the window size set with the setblockwin action.
+ *
+ * It only exists while a window larger than `rolling_window_size` is set or the slots of a larger window are still
+ * being erased, so at the default window the onblock action records each block in the blockinfo table alone. A larger
+ * window, up to `max_rolling_window_size`, is also recorded in the blockring table. The singleton is only written by
+ * setblockwin and once the slots beyond a shrunk window have all been erased.
+ */
+struct [[eosio::table("blockwindow"), eosio::contract("eosio.system")]] block_info_window
+{
+   uint8_t  version     = 0;
+   uint32_t window_size = rolling_window_size;
+   bool     shrinking   = false; // slots beyond the window are still being erased
+
+   // Number of blocks recorded in the blockring table, 0 while the blockinfo table alone holds the window.
+   uint32_t ring_size() const { return window_size > rolling_window_size ? window_size : 0; }
+
+   EOSLIB_SERIALIZE(block_info_window, (version)(window_size)(shrinking))
+};
+
+using block_info_window_singleton = eosio::singleton<"blockwindow"_n, block_info_window>;
+
+/**
+ * The blockring table holds the blocks of a window larger than the blockinfo table as a fixed set of slots.
+ *
+ * The block at height `h` is recorded in slot `h % window_size`, overwriting the block recorded there
+ * `window_size` blocks earlier, so the onblock action modifies a single row instead of adding one and erasing old ones.
+ * A slot only describes block `h` if its `block_height` is `h`; slots left beyond a shrunk window are erased by the
+ * onblock action, up to two at a time.
+ */
+struct [[eosio::table, eosio::contract("eosio.system")]] block_info_slot
+{
+   uint8_t           version = 0;
+   uint32_t          slot;
+   uint32_t          block_height;
+   eosio::time_point block_timestamp;
+
+   uint64_t primary_key() const { return slot; }
+
+   EOSLIB_SERIALIZE(block_info_slot, (version)(slot)(block_height)(block_timestamp))
+};
+
+using block_info_ring_table = eosio::multi_index<"blockring"_n, block_info_slot>;
+
+/**
+ * Sparse checkpoints kept beyond the rolling window: every `interval`-th block is recorded in the blockchkpt table,
+ * scoped by `interval`, in slot `(block_height / interval) % slots`, so each level holds its last `slots` checkpoints.
+ */
+struct block_checkpoint_level
+{
+   uint32_t interval;
+   uint32_t slots;
+};
+
+static constexpr block_checkpoint_level checkpoint_levels[] = {
+   { 120, 1440 }, // every minute, for one day
+   { 7200, 720 }, // every hour, for 30 days
+};
+
+struct [[eosio::table, eosio::contract("eosio.system")]] block_checkpoint
+{
+   uint8_t           version = 0;
+   uint32_t          slot;
+   uint32_t          block_height;
+   eosio::time_point block_timestamp;
+
+   uint64_t primary_key() const { return slot; }
+
+   EOSLIB_SERIALIZE(block_checkpoint, (version)(slot)(block_height)(block_timestamp))
+};
+
+using block_checkpoint_table = eosio::multi_index<"blockchkpt"_n, block_checkpoint>;
+
+struct recorded_block
+{
+   uint32_t          block_height;
+   eosio::time_point block_timestamp;
+};
+
+namespace detail {
+
+// Block `block_height` as recorded in a table holding every `interval`-th block in `slots` slots, if it is still there.
+template <typename Table>
+std::optional<recorded_block> find_recorded_block(const Table& t, uint32_t interval, uint32_t slots,
+                                                  uint32_t block_height)
+{
+   if (slots == 0 || block_height % interval != 0) {
+      return {};
+   }
+
+   auto itr = t.find((block_height / interval) % slots);
+   if (itr == t.cend() || itr->version != 0 || itr->block_height != block_height) {
+      return {};
+   }
+
+   return recorded_block{ itr->block_height, itr->block_timestamp };
+}
+
+// Latest block with a timestamp at or before `timestamp` among those the table can hold, found by binary search over
+// its at most `slots` blocks. Missing blocks are treated as older than `timestamp`, which they are unless onblock
+// failed.
+template <typename Table>
+std::optional<recorded_block> find_recorded_block_at_or_before(const Table& t, uint32_t interval, uint32_t slots,
+                                                               uint32_t          latest_block_height,
+                                                               eosio::time_point timestamp)
+{
+   std::optional<recorded_block> found;
+
+   if (slots == 0) {
+      return found;
+   }
+
+   const uint32_t newest = latest_block_height / interval;
+   uint32_t       lo     = newest >= slots - 1 ? newest - (slots - 1) : 0;
+   uint32_t       hi     = newest + 1;
+
+   while (lo < hi) {
+      const uint32_t mid    = lo + (hi - lo) / 2;
+      auto           record = find_recorded_block(t, interval, slots, mid * interval);
+      if (record && record->block_timestamp > timestamp) {
+         hi = mid;
+      } else {
+         if (record) {
+            found = record;
+         }
+         lo = mid + 1;
+      }
+   }
+
+   return found;
+}
+
+// Number of blocks recorded in the blockring table, 0 unless setblockwin has set a window larger than the blockinfo
+// table.
+uint32_t get_ring_size(eosio::name system_account_name)
+{
+   block_info_window_singleton window_singleton(system_account_name, 0);
+   if (!window_singleton.exists()) {
+      return 0;
+   }
+
+   const block_info_window window = window_singleton.get();
+   return window.version == 0 ? window.ring_size() : 0;
+}
+
+// Block `block_height`, older than those in the blockinfo table, as recorded in the blockring table or among the
+// checkpoints, given the latest recorded block.
+std::optional<recorded_block> find_older_block(eosio::name system_account_name,
+                                               uint32_t    latest_block_height,
+                                               uint32_t    block_height)
+{
+   if (latest_block_height < block_height) {
+      return {};
+   }
+
+   const uint32_t ring_size = get_ring_size(system_account_name);
+   if (latest_block_height - block_height < ring_size) {
+      block_info_ring_table t(system_account_name, 0);
+      if (auto record = find_recorded_block(t, 1, ring_size, block_height)) {
+         return record;
+      }
+   }
+
+   for (const auto& level : checkpoint_levels) {
+      block_checkpoint_table checkpoints(system_account_name, level.interval);
+      if (auto record = find_recorded_block(checkpoints, level.interval, level.slots, block_height)) {
+         return record;
+      }
+   }
+
+   return {};
+}
+
+} // namespace detail
+// TELOS END
+
 struct block_batch_info
 {
    uint32_t          batch_start_height;
@@ -80,6 +262,8 @@ struct latest_block_batch_info_result
  * Furthermore, if `batch_start_height_offset` is greater than the height of the latest block for which
  * information is recorded in the blockinfo table, there will be no latest block batch identified for the function to
  * return information about and so it will again be forced to return the `insufficient_data` error code instead.
+ * A start block older than the blockinfo table is also looked up in the blockring table, if setblockwin has set a
+ * larger window, and among the checkpoints.
  */
 latest_block_batch_info_result get_latest_block_batch_info(uint32_t    batch_start_height_offset,
                                                            uint32_t    batch_size,
@@ -142,6 +326,22 @@ latest_block_batch_info_result get_latest_block_batch_info(uint32_t    batch_sta
    // Find information on start block of the latest block batch recorded in the blockinfo table.
 
    auto start_block_info_itr = t.find(latest_block_batch_start_height);
+
+   // TELOS BEGIN
+   if (start_block_info_itr == t.cend()) {
+      if (auto record = detail::find_older_block(system_account_name, latest_block_batch_end_height,
+                                                 latest_block_batch_start_height)) {
+         result.result.emplace(block_batch_info{
+            .batch_start_height          = latest_block_batch_start_height,
+            .batch_start_timestamp       = record->block_timestamp,
+            .batch_current_end_height    = latest_block_batch_end_height,
+            .batch_current_end_timestamp = latest_block_info_itr->block_timestamp,
+         });
+         return result;
+      }
+   }
+   // TELOS END
+
    if (start_block_info_itr == t.cend() || start_block_info_itr->block_height != latest_block_batch_start_height) {
       // Record for information on start block of the latest block batch could not be found in blockinfo table.
       // This is either because of:
@@ -172,4 +372,100 @@ latest_block_batch_info_result get_latest_block_batch_info(uint32_t    batch_sta
    return result;
 }
 
+// TELOS BEGIN
+/**
+ * Get the recorded height and timestamp of block `block_height`.
+ *
+ * The block is found if it is within the rolling window of the blockinfo table or of the blockring table, or if it is
+ * one of the checkpoints still kept for a `checkpoint_levels` entry, that is every 120th block of the last day and
+ * every 7200th block of the last 30 days.
+ */
+std::optional<recorded_block> get_recorded_block(uint32_t block_height, eosio::name system_account_name = "eosio"_n)
+{
+   block_info_table t(system_account_name, 0);
+   if (t.cbegin() == t.cend()) {
+      return {};
+   }
+
+   auto itr = t.find(block_height);
+   if (itr != t.cend()) {
+      if (itr->version != 0) {
+         return {};
+      }
+      return recorded_block{ itr->block_height, itr->block_timestamp };
+   }
+
+   return detail::find_older_block(system_account_name, (--t.cend())->block_height, block_height);
+}
+
+/**
+ * Get the latest recorded block with a timestamp at or before `timestamp`.
+ *
+ * The rolling window is searched first, so within it the result is exact. Older timestamps are looked up among the
+ * checkpoints, from the finest level to the coarsest, in which case the result is the latest checkpoint at or before
+ * `timestamp` and can be up to one checkpoint interval earlier than the exact block.
+ * The blockring table and each checkpoint level are binary searched, so a lookup reads a logarithmic number of rows.
+ * Returns nothing if `timestamp` is older than every recorded block.
+ */
+std::optional<recorded_block> get_recorded_block_at_or_before(eosio::time_point timestamp,
+                                                              eosio::name       system_account_name = "eosio"_n)
+{
+   block_info_table t(system_account_name, 0);
+   if (t.cbegin() == t.cend()) {
+      return {};
+   }
+
+   const uint32_t latest_block_height = (--t.cend())->block_height;
+
+   // The blockinfo table holds the latest rolling_window_size blocks, so it is scanned from the latest one.
+   for (auto itr = t.cend(); itr != t.cbegin();) {
+      --itr;
+      if (itr->version == 0 && itr->block_timestamp <= timestamp) {
+         return recorded_block{ itr->block_height, itr->block_timestamp };
+      }
+   }
+
+   if (const uint32_t ring_size = detail::get_ring_size(system_account_name)) {
+      block_info_ring_table ring(system_account_name, 0);
+      if (auto record =
+             detail::find_recorded_block_at_or_before(ring, 1, ring_size, latest_block_height, timestamp)) {
+         return record;
+      }
+   }
+
+   for (const auto& level : checkpoint_levels) {
+      block_checkpoint_table checkpoints(system_account_name, level.interval);
+      if (auto record = detail::find_recorded_block_at_or_before(checkpoints, level.interval, level.slots,
+                                                                 latest_block_height, timestamp)) {
+         return record;
+      }
+   }
+
+   return {};
+}
+
+/**
+ * Get the number of blocks produced in the wall-clock interval (`start`, `end`], as the difference between the heights
+ * of the latest recorded blocks at or before `end` and at or before `start`.
+ *
+ * The count is exact while both ends are within the rolling window; otherwise it is measured between checkpoints.
+ */
+std::optional<uint32_t> get_block_count_between(eosio::time_point start,
+                                                eosio::time_point end,
+                                                eosio::name       system_account_name = "eosio"_n)
+{
+   if (end < start) {
+      return {};
+   }
+
+   auto start_block = get_recorded_block_at_or_before(start, system_account_name);
+   auto end_block   = get_recorded_block_at_or_before(end, system_account_name);
+   if (!start_block || !end_block) {
+      return {};
+   }
+
+   return end_block->block_height - start_block->block_height;
+}
+// TELOS END
+
 } // namespace eosiosystem::block_info
@@ -10,6 +10,9 @@
 
 #include <eosio.system/exchange_state.hpp>
 #include <eosio.system/native.hpp>
+// TELOS BEGIN
+#include <eosio.system/schedule_policy.hpp>
+// TELOS END
 
 #include <deque>
 #include <optional>
@@ -17,7 +20,9 @@
 #include <type_traits>
 
 // TELOS BEGIN
+#include <algorithm>
 #include <cmath>
+#include <numeric>
 // TELOS END
 #ifdef CHANNEL_RAM_AND_NAMEBID_FEES_TO_REX
 #undef CHANNEL_RAM_AND_NAMEBID_FEES_TO_REX
@@ -118,12 +123,60 @@ namespace eosiosystem {
 
    typedef eosio::multi_index< "payments"_n, payment_info > payments_table;
 
+   // Producers that have their pay transferred when a pay period is settled, instead of claiming it.
+   struct [[eosio::table, eosio::contract("eosio.system")]] auto_payout {
+      name producer;
+
+      uint64_t primary_key() const { return producer.value; }
+
+      EOSLIB_SERIALIZE( auto_payout, (producer) )
+   };
+
+   typedef eosio::multi_index< "autopay"_n, auto_payout > auto_payout_table;
+
+   // Mixes a producer name into 64 bits (splitmix64 finalizer). The fingerprint of a schedule is the wrapping
+   // sum of its mixed names, so it can be compared without sorting either schedule.
+   inline uint64_t producer_fingerprint( const name& producer ) {
+      uint64_t z = producer.value;
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+      return z ^ (z >> 31);
+   }
+
    struct [[eosio::table("schedulemetr"), eosio::contract("eosio.system")]] schedule_metrics_state {
      name                             last_onblock_caller;
      int32_t                          block_counter_correction;
      std::vector<producer_metric>     producers_metric;
+     binary_extension<uint64_t>       schedule_fingerprint; ///< sum of producer_fingerprint over producers_metric, set when a schedule is proposed
+     binary_extension<std::vector<uint8_t>> slots_by_name; ///< positions in producers_metric ordered by bp_name, set with producers_metric
 
      uint64_t primary_key()const { return last_onblock_caller.value; }
+
+     // rebuilds slots_by_name, call whenever producers_metric is replaced
+     void index_slots() {
+        std::vector<uint8_t> slots(producers_metric.size());
+        std::iota(slots.begin(), slots.end(), 0);
+        std::sort(slots.begin(), slots.end(), [&](uint8_t a, uint8_t b) {
+           return producers_metric[a].bp_name < producers_metric[b].bp_name;
+        });
+        slots_by_name.emplace(std::move(slots));
+     }
+
+     // metric of `producer` in the current schedule, or nullptr when it is not scheduled
+     producer_metric* find_metric(const name& producer) {
+        if (slots_by_name.has_value() && slots_by_name.value().size() == producers_metric.size()) {
+           const auto& slots = slots_by_name.value();
+           auto it = std::lower_bound(slots.begin(), slots.end(), producer, [&](uint8_t slot, const name& p) {
+              return producers_metric[slot].bp_name < p;
+           });
+           return it != slots.end() && producers_metric[*it].bp_name == producer ? &producers_metric[*it] : nullptr;
+        }
+        // metrics written before the index was kept
+        for (auto &pm : producers_metric) {
+           if (pm.bp_name == producer) return &pm;
+        }
+        return nullptr;
+     }
    };
 
    typedef eosio::singleton< "schedulemetr"_n, schedule_metrics_state > schedule_metrics_singleton;
@@ -156,6 +209,93 @@ namespace eosiosystem {
 
    typedef eosio::singleton< "payrate"_n, payrates > payrate_singleton;
 
+   // Tracks a resumable recount of producer votes, started when `total_producer_vote_weight` drifts negative.
+   // The recount walks the producers and voters tables in bounded slices:
+   // - `stage` is one of the `vote_repair_stage` values, `idle` when no recount is running,
+   // - `cursor` the next producer (resetting producers) or voter (resetting and recounting voters) to process.
+   struct [[eosio::table("voterepair"), eosio::contract("eosio.system")]] vote_repair_state {
+      enum vote_repair_stage : uint8_t {
+         idle             = 0,
+         reset_producers  = 1,
+         reset_voters     = 2,
+         recount_voters   = 3
+      };
+
+      static constexpr uint32_t rows_per_block = 50; // rows processed by each onblock while a recount is running
+
+      uint8_t  stage = idle;
+      name     cursor;
+
+      bool in_progress()const { return stage != idle; }
+
+      EOSLIB_SERIALIZE( vote_repair_state, (stage)(cursor) )
+   };
+
+   typedef eosio::singleton< "voterepair"_n, vote_repair_state > vote_repair_singleton;
+
+   // Producer pay of the last closed snapshot period. Closing a period in onblock ranks the producers, fixes the
+   // share value and clears their unpaid blocks; their `payments` rows are credited afterwards, `settle_per_block`
+   // per onblock, by settlepay, or by claimrewards.
+   struct [[eosio::table("payperiod"), eosio::contract("eosio.system")]] pay_period_state {
+      static constexpr uint32_t settle_per_block = 7;
+
+      time_point           closed_at;
+      int64_t              share_value = 0;
+      std::vector<name>    ranked;     ///< active producers in vote order when the period closed, the top producers earn two shares
+      uint32_t             cursor = 0; ///< next entry of `ranked` to credit
+
+      bool pending()const { return cursor < ranked.size(); }
+
+      EOSLIB_SERIALIZE( pay_period_state, (closed_at)(share_value)(ranked)(cursor) )
+   };
+
+   typedef eosio::singleton< "payperiod"_n, pay_period_state > pay_period_singleton;
+
+   // Last TLOS/USD average read from delphioracle, reused until a snapshot period has passed
+   struct [[eosio::table("tlosprice"), eosio::contract("eosio.system")]] tlos_price_state {
+      static constexpr int64_t refresh_interval_us = 1800 * 1'000'000ll; // 3600 slots, one pay snapshot period
+
+      uint64_t    price = 0;
+      time_point  updated_at;
+
+      EOSLIB_SERIALIZE( tlos_price_state, (price)(updated_at) )
+   };
+
+   typedef eosio::singleton< "tlosprice"_n, tlos_price_state > tlos_price_singleton;
+
+   // Token flows of a TEDP pay call: `issue` is issued to and transferred from eosio to the TEDP account so that its
+   // balance covers `payout`, then TEDP pays the `due` payouts. `next_due` is the earliest time a payout that is not due
+   // yet can become due.
+   struct tedp_pay_flows {
+      asset              payout;
+      asset              tedp_balance;
+      asset              issue;
+      std::vector<name>  due;
+      time_point_sec     next_due;
+
+      EOSLIB_SERIALIZE( tedp_pay_flows, (payout)(tedp_balance)(issue)(due)(next_due) )
+   };
+
+   // REX maintenance settings. While `scheduled` is set, REX user actions only distribute REX returns and leave expired
+   // loans and queued sell orders to rexexec, which processes at most the budget of each category per call.
+   struct [[eosio::table("rexmaint"), eosio::contract("eosio.system")]] rex_maintenance_state {
+      bool     scheduled         = false;
+      uint16_t cpu_loan_budget   = 2;
+      uint16_t net_loan_budget   = 2;
+      uint16_t sell_order_budget = 2;
+
+      EOSLIB_SERIALIZE( rex_maintenance_state, (scheduled)(cpu_loan_budget)(net_loan_budget)(sell_order_budget) )
+   };
+
+   typedef eosio::singleton< "rexmaint"_n, rex_maintenance_state > rex_maintenance_singleton;
+
+   // Work done by one REX maintenance run
+   struct rex_maintenance_result {
+      uint16_t cpu_loans   = 0;
+      uint16_t net_loans   = 0;
+      uint16_t sell_orders = 0;
+   };
+
 
    enum class kick_type {
       REACHED_TRESHOLD = 1,
@@ -485,6 +625,51 @@ namespace eosiosystem {
 
    typedef eosio::singleton< "global4"_n, eosio_global_state4 > global_state4_singleton;
 
+   // Holds the row of a singleton for the duration of an action.
+   // The row is read the first time it is accessed and its packed form is remembered, so that `save` writes
+   // the row back only if it changed or if it did not exist yet.
+   // Singletons an action never touches are neither read nor written.
+   template<typename Singleton, typename T>
+   class cached_singleton {
+      public:
+         cached_singleton( name code, uint64_t scope, T (*make_default)() )
+         :_table(code, scope), _make_default(make_default) {}
+
+         T& operator*()             { return load(); }
+         const T& operator*()const  { return load(); }
+         T* operator->()            { return &load(); }
+         const T* operator->()const { return &load(); }
+
+         void save( name payer ) {
+            if( !_loaded ) return;
+            if( _dirty || eosio::pack( _value ) != _packed ) {
+               _table.set( _value, payer );
+            }
+         }
+
+      private:
+         T& load()const {
+            if( !_loaded ) {
+               if( _table.exists() ) {
+                  _value  = _table.get();
+                  _packed = eosio::pack( _value );
+               } else {
+                  _value = _make_default();
+                  _dirty = true;
+               }
+               _loaded = true;
+            }
+            return _value;
+         }
+
+         mutable Singleton         _table;
+         T                         (*_make_default)();
+         mutable T                 _value;
+         mutable std::vector<char> _packed;
+         mutable bool              _loaded = false;
+         mutable bool              _dirty  = false;
+   };
+
    struct [[eosio::table, eosio::contract("eosio.system")]] user_resources {
       name          owner;
       asset         net_weight;
@@ -531,6 +716,25 @@ namespace eosiosystem {
    typedef eosio::multi_index< "delband"_n, delegated_bandwidth > del_bandwidth_table;
    typedef eosio::multi_index< "refunds"_n, refund_request >      refunds_table;
 
+   // TELOS BEGIN
+   // Running total of the tokens `owner` has delegated through its `delband` table, so that voteupdate
+   // does not have to walk every delegation. The total is only authoritative once `reconciled` is set;
+   // until then reconcilebw is summing the delegations page by page, starting at `next_receiver`.
+   struct [[eosio::table, eosio::contract("eosio.system")]] delegated_total {
+      name          owner;
+      int64_t       delegated = 0;
+      name          next_receiver;
+      bool          reconciled = false;
+
+      uint64_t primary_key()const { return owner.value; }
+
+      // explicit serialization macro is not necessary, used here only to improve compilation time
+      EOSLIB_SERIALIZE( delegated_total, (owner)(delegated)(next_receiver)(reconciled) )
+   };
+
+   typedef eosio::multi_index< "delegatedtot"_n, delegated_total > delegated_totals_table;
+   // TELOS END
+
    // `rex_pool` structure underlying the rex pool table. A rex pool table entry is defined by:
    // - `version` defaulted to zero,
    // - `total_lent` total amount of CORE_SYMBOL in open rex_loans
@@ -594,7 +798,31 @@ namespace eosiosystem {
    // - `return_buckets` buckets of proceeds accumulated in 12-hour intervals
    struct [[eosio::table,eosio::contract("eosio.system")]] rex_return_buckets {
       uint8_t                                version = 0;
-      std::vector<pair_time_point_sec_int64> return_buckets;  // sorted by first field
+      std::vector<pair_time_point_sec_int64> return_buckets;  // sorted by first field in version zero
+      // TELOS BEGIN
+      // From `ring_version` on, `return_buckets` holds `total_buckets` slots and a bucket lives in the slot of its time.
+      // Empty slots hold a zero time.
+
+      static constexpr uint8_t  ring_version    = 1;
+      static constexpr uint32_t bucket_interval = rex_return_pool::hours_per_bucket * seconds_per_hour;
+      static constexpr uint32_t total_buckets   = rex_return_pool::total_intervals * rex_return_pool::dist_interval / bucket_interval;
+      static_assert( total_buckets * bucket_interval == rex_return_pool::total_intervals * rex_return_pool::dist_interval );
+
+      static uint32_t slot( const time_point_sec& bucket_time ) {
+         return bucket_time.sec_since_epoch() / bucket_interval % total_buckets;
+      }
+
+      // moves buckets of the sorted layout into their slots, a no-op once the ring layout is used
+      void to_ring() {
+         if ( version >= ring_version ) return;
+         std::vector<pair_time_point_sec_int64> ring( total_buckets, pair_time_point_sec_int64{} );
+         for ( const auto& bucket : return_buckets ) {
+            ring[ slot( bucket.first ) ] = bucket;
+         }
+         return_buckets = std::move( ring );
+         version        = ring_version;
+      }
+      // TELOS END
 
       uint64_t primary_key()const { return 0; }
    };
@@ -669,6 +897,40 @@ namespace eosiosystem {
                                indexed_by<"byowner"_n, const_mem_fun<rex_loan, uint64_t, &rex_loan::by_owner>>
                              > rex_net_loan_table;
 
+   // TELOS BEGIN
+   enum class rex_loan_resource : uint8_t {
+      cpu = 0,
+      net = 1
+   };
+
+   // `rex_resource_loan` structure underlying the `rex_loan_table`, which holds CPU and NET loans in one expiration queue.
+   // An entry has the fields of `rex_loan` and
+   // - `resource` the rented resource, a `rex_loan_resource`.
+   // Loans in the `rex_cpu_loan_table` and `rex_net_loan_table` stay and renew there until they are closed.
+   struct [[eosio::table,eosio::contract("eosio.system")]] rex_resource_loan {
+      uint8_t             version = 0;
+      name                from;
+      name                receiver;
+      asset               payment;
+      asset               balance;
+      asset               total_staked;
+      uint64_t            loan_num;
+      eosio::time_point   expiration;
+      uint8_t             resource = static_cast<uint8_t>(rex_loan_resource::cpu);
+
+      bool is_cpu()const          { return resource == static_cast<uint8_t>(rex_loan_resource::cpu); }
+
+      uint64_t primary_key()const { return loan_num;                   }
+      uint64_t by_expr()const     { return expiration.elapsed.count(); }
+      uint64_t by_owner()const    { return from.value;                 }
+   };
+
+   typedef eosio::multi_index< "rexloans"_n, rex_resource_loan,
+                               indexed_by<"byexpr"_n,  const_mem_fun<rex_resource_loan, uint64_t, &rex_resource_loan::by_expr>>,
+                               indexed_by<"byowner"_n, const_mem_fun<rex_resource_loan, uint64_t, &rex_resource_loan::by_owner>>
+                             > rex_loan_table;
+   // TELOS END
+
    struct [[eosio::table,eosio::contract("eosio.system")]] rex_order {
       uint8_t             version = 0;
       name                owner;
@@ -809,6 +1071,23 @@ namespace eosiosystem {
                                indexed_by<"byexpires"_n, const_mem_fun<powerup_order, uint64_t, &powerup_order::by_expires>>
                                > powerup_order_table;
 
+   // TELOS BEGIN
+   // Producer vote deltas summed over a batch of vote updates, sorted by producer, so that voteupdates
+   // modifies every affected producer once at the end of the batch.
+   struct producer_vote_deltas {
+      std::vector<std::pair<name, double>> deltas;
+
+      void add( const name& producer, double delta ) {
+         auto itr = std::lower_bound( deltas.begin(), deltas.end(), producer,
+                                      []( const auto& d, const name& p ) { return d.first < p; } );
+         if( itr == deltas.end() || itr->first != producer ) {
+            itr = deltas.emplace( itr, producer, 0.0 );
+         }
+         itr->second += delta;
+      }
+   };
+   // TELOS END
+
    /**
     * The `eosio.system` smart contract is provided by `block.one` as a sample system contract, and it defines the structures and actions needed for blockchain's core functionality.
     *
@@ -829,14 +1108,10 @@ namespace eosiosystem {
          voters_table             _voters;
          producers_table          _producers;
          producers_table2         _producers2;
-         global_state_singleton   _global;
-         global_state2_singleton  _global2;
-         global_state3_singleton  _global3;
-         global_state4_singleton  _global4;
-         eosio_global_state       _gstate;
-         eosio_global_state2      _gstate2;
-         eosio_global_state3      _gstate3;
-         eosio_global_state4      _gstate4;
+         cached_singleton<global_state_singleton, eosio_global_state>    _gstate;
+         cached_singleton<global_state2_singleton, eosio_global_state2>  _gstate2;
+         cached_singleton<global_state3_singleton, eosio_global_state3>  _gstate3;
+         cached_singleton<global_state4_singleton, eosio_global_state4>  _gstate4;
          rammarket                _rammarket;
          rex_pool_table           _rexpool;
          rex_return_pool_table    _rexretpool;
@@ -846,13 +1121,15 @@ namespace eosiosystem {
          rex_order_table          _rexorders;
 
          // TELOS BEGIN
-         schedule_metrics_singleton  _schedule_metrics;
-         schedule_metrics_state      _gschedule_metrics;
-         rotation_singleton          _rotation;
-         rotation_state              _grotation;
-         payrate_singleton           _payrate;
-         payrates                    _gpayrate;
-         payments_table              _payments;
+         cached_singleton<schedule_metrics_singleton, schedule_metrics_state>  _gschedule_metrics;
+         cached_singleton<rotation_singleton, rotation_state>                  _grotation;
+         cached_singleton<payrate_singleton, payrates>                         _gpayrate;
+         cached_singleton<vote_repair_singleton, vote_repair_state>            _gvoterepair;
+         cached_singleton<pay_period_singleton, pay_period_state>              _gpayperiod;
+         cached_singleton<tlos_price_singleton, tlos_price_state>              _gtlosprice;
+         cached_singleton<rex_maintenance_singleton, rex_maintenance_state>    _grexmaint;
+         payments_table                                                        _payments;
+         auto_payout_table                                                     _autopay;
          // TELOS END
 
       public:
@@ -1169,6 +1446,8 @@ namespace eosiosystem {
          /**
           * Rexexec action, processes max CPU loans, max NET loans, and max queued sellrex orders.
           * Action does not execute anything related to a specific user.
+          * While REX maintenance is scheduled, each category is also capped by its budget set with setrexmaint,
+          * and a `rex.results::execresult` summary is sent when anything was processed.
           *
           * @param user - any account can execute this action,
           * @param max - number of each of CPU loans, NET loans, and sell orders to be processed.
@@ -1393,6 +1672,18 @@ namespace eosiosystem {
          [[eosio::action]]
          void voteupdate( const name& voter_name );
 
+         // TELOS BEGIN
+         /**
+          * Batch vote update action, runs `voteupdate` for every account in `voters` and applies the
+          * resulting producer vote changes once per producer at the end, instead of once per voter.
+          * Requires the authority of every listed voter, like `voteupdate`.
+          *
+          * @param voters - the accounts to update the votes for.
+          */
+         [[eosio::action]]
+         void voteupdates( const std::vector<name>& voters );
+         // TELOS END
+
          /**
           * Register proxy action, sets `proxy` account as proxy.
           * An account marked as a proxy can vote with the weight of other accounts which
@@ -1591,6 +1882,7 @@ namespace eosiosystem {
          using setramrate_action = eosio::action_wrapper<"setramrate"_n, &system_contract::setramrate>;
          using voteproducer_action = eosio::action_wrapper<"voteproducer"_n, &system_contract::voteproducer>;
          using voteupdate_action = eosio::action_wrapper<"voteupdate"_n, &system_contract::voteupdate>;
+         using voteupdates_action = eosio::action_wrapper<"voteupdates"_n, &system_contract::voteupdates>; // TELOS
          using regproxy_action = eosio::action_wrapper<"regproxy"_n, &system_contract::regproxy>;
          using claimrewards_action = eosio::action_wrapper<"claimrewards"_n, &system_contract::claimrewards>;
          using rmvproducer_action = eosio::action_wrapper<"rmvproducer"_n, &system_contract::rmvproducer>;
@@ -1621,11 +1913,98 @@ namespace eosiosystem {
          [[eosio::action]]
          void pay();
 
+         /**
+          * Pay preview action, returns the token flows pay would execute now without executing them.
+          * An empty `due` list means pay would fail with "No payouts are due".
+          */
+         [[eosio::action, eosio::read_only]]
+         tedp_pay_flows paypreview();
+
+         /**
+          * Repair votes action, advances a running producer vote recount by at most `max` rows.
+          * Any account can push this action to finish a recount faster than onblock does on its own.
+          *
+          * @param max - number of producer and voter rows to process.
+          *
+          * @pre A vote recount must be in progress
+          */
+         [[eosio::action]]
+         void repairvotes( uint16_t max );
+
+         /**
+          * Settle pay action, credits at most `max` producers of the last closed pay period to the payments table.
+          * Any account can push this action; onblock and claimrewards settle the period on their own as well.
+          *
+          * @param max - number of producers to credit.
+          *
+          * @pre The last closed pay period must have producers left to credit
+          */
+         [[eosio::action]]
+         void settlepay( uint16_t max );
+
+         /**
+          * Set auto payout action, lets `producer` have its pay transferred to it when the pay period it earned it in
+          * is settled, without pushing claimrewards. Any pay already waiting in the payments table is transferred
+          * along with the next settled pay.
+          *
+          * @param producer - the producer setting its preference,
+          * @param enabled - whether pay is transferred automatically.
+          *
+          * @pre Producer must be registered
+          * @pre Producer account must not have contract code, which could reject the transfer
+          */
+         [[eosio::action]]
+         void setautopay( const name& producer, bool enabled );
+
+         /**
+          * Reconcile bandwidth action, rebuilds the running total of tokens `owner` has delegated by summing
+          * at most `max` of its delegations per call. Once every delegation has been summed the total is marked
+          * reconciled and voteupdate uses it instead of walking the delegations.
+          * Calling it on an already reconciled total starts a new verification pass.
+          *
+          * @param owner - the account whose delegated total is rebuilt,
+          * @param max - number of delegations to sum in this call.
+          */
+         [[eosio::action]]
+         void reconcilebw( const name& owner, uint16_t max );
+
+         /**
+          * Set block window action, sets how many recent blocks `block_info::get_latest_block_batch_info` can
+          * look up. A window larger than the blockinfo table is also recorded in the blockring table; slots beyond a
+          * smaller window are erased by onblock, two at a time.
+          *
+          * @param window_size - number of recent blocks to keep, from `block_info::rolling_window_size` up to
+          * `block_info::max_rolling_window_size`.
+          */
+         [[eosio::action]]
+         void setblockwin( uint32_t window_size );
+
+         /**
+          * Set REX maintenance action, moves the processing of expired loans and queued sell orders out of REX user
+          * actions and into rexexec calls, or back.
+          *
+          * @param scheduled - if true, only rexexec processes expired loans and queued sell orders,
+          * @param cpu_loan_budget - maximum number of expired CPU loans processed by one rexexec,
+          * @param net_loan_budget - maximum number of expired NET loans processed by one rexexec,
+          * @param sell_order_budget - maximum number of queued sell orders processed by one rexexec.
+          *
+          * @pre Budgets must be positive when maintenance is scheduled
+          */
+         [[eosio::action]]
+         void setrexmaint( bool scheduled, uint16_t cpu_loan_budget, uint16_t net_loan_budget, uint16_t sell_order_budget );
+
          using unregreason_action = eosio::action_wrapper<"unregreason"_n, &system_contract::unregreason>;
          using votebpout_action = eosio::action_wrapper<"votebpout"_n, &system_contract::votebpout>;
          using setpayrates_action = eosio::action_wrapper<"setpayrates"_n, &system_contract::setpayrates>;
          using distviarex_action = eosio::action_wrapper<"distviarex"_n, &system_contract::distviarex>;
          using pay_action = eosio::action_wrapper<"pay"_n, &system_contract::pay>;
+         using paypreview_action = eosio::action_wrapper<"paypreview"_n, &system_contract::paypreview>;
+         using repairvotes_action = eosio::action_wrapper<"repairvotes"_n, &system_contract::repairvotes>;
+         using settlepay_action = eosio::action_wrapper<"settlepay"_n, &system_contract::settlepay>;
+         using setautopay_action = eosio::action_wrapper<"setautopay"_n, &system_contract::setautopay>;
+         using reconcilebw_action = eosio::action_wrapper<"reconcilebw"_n, &system_contract::reconcilebw>;
+         using setblockwin_action = eosio::action_wrapper<"setblockwin"_n, &system_contract::setblockwin>;
+         using setrexmaint_action = eosio::action_wrapper<"setrexmaint"_n, &system_contract::setrexmaint>;
          // TELOS END
 
       private:
@@ -1645,16 +2024,28 @@ namespace eosiosystem {
 
          // defined in rex.cpp
          void runrex( uint16_t max );
+         // TELOS BEGIN
+         rex_maintenance_result process_rex_queues( uint16_t max_cpu_loans, uint16_t max_net_loans, uint16_t max_sell_orders );
+         // TELOS END
          void update_rex_pool();
          void update_resource_limits( const name& from, const name& receiver, int64_t delta_net, int64_t delta_cpu );
          void check_voting_requirement( const name& owner,
                                         const char* error_msg = "must vote for at least 21 producers or for a proxy before buying REX" )const;
-         rex_order_outcome fill_rex_order( const rex_balance_table::const_iterator& bitr, const asset& rex );
+         rex_order_outcome fill_rex_order( rex_pool& pool, rex_balance& rb, const asset& rex );
+         // TELOS BEGIN
+         // core tokens a sell order can take from the pool, which keeps a tenth of the lent amount unlent; may be negative
+         static int64_t available_unlent( const rex_pool& pool ) {
+            return pool.total_unlent.amount - pool.total_lent.amount / 10;
+         }
+         // TELOS END
          asset update_rex_account( const name& owner, const asset& proceeds, const asset& unstake_quant, bool force_vote_update = false );
          void channel_to_rex( const name& from, const asset& amount, bool required = false );
          void channel_namebid_to_rex( const int64_t highest_bid );
-         template <typename T>
-         int64_t rent_rex( T& table, const name& from, const name& receiver, const asset& loan_payment, const asset& loan_fund );
+         int64_t rent_rex( rex_loan_resource resource, const name& from, const name& receiver, const asset& loan_payment, const asset& loan_fund );
+         // TELOS BEGIN
+         template <typename F>
+         void with_rex_loan_table( rex_loan_resource resource, uint64_t loan_num, F&& f );
+         // TELOS END
          template <typename T>
          void fund_rex_loan( T& table, const name& from, uint64_t loan_num, const asset& payment );
          template <typename T>
@@ -1668,15 +2059,16 @@ namespace eosiosystem {
          asset add_to_rex_balance( const name& owner, const asset& payment, const asset& rex_received );
          asset add_to_rex_pool( const asset& payment );
          void add_to_rex_return_pool( const asset& fee );
-         void process_rex_maturities( const rex_balance_table::const_iterator& bitr );
-         void consolidate_rex_balance( const rex_balance_table::const_iterator& bitr,
-                                       const asset& rex_in_sell_order );
-         int64_t read_rex_savings( const rex_balance_table::const_iterator& bitr );
-         void put_rex_savings( const rex_balance_table::const_iterator& bitr, int64_t rex );
+         void process_rex_maturities( rex_balance& rb );
+         void save_rex_balance( const rex_balance_table::const_iterator& bitr, const rex_balance& rb );
+         void consolidate_rex_balance( rex_balance& rb, const asset& rex_in_sell_order );
+         int64_t read_rex_savings( rex_balance& rb );
+         void put_rex_savings( rex_balance& rb, int64_t rex );
          void update_rex_stake( const name& voter );
 
          void add_loan_to_rex_pool( const asset& payment, int64_t rented_tokens, bool new_loan );
-         void remove_loan_from_rex_pool( const rex_loan& loan );
+         template <typename Loan>
+         void remove_loan_from_rex_pool( const Loan& loan );
          template <typename Index, typename Iterator>
          int64_t update_renewed_loan( Index& idx, const Iterator& itr, int64_t rented_tokens );
 
@@ -1684,12 +2076,16 @@ namespace eosiosystem {
          void changebw( name from, const name& receiver,
                         const asset& stake_net_quantity, const asset& stake_cpu_quantity, bool transfer );
          void update_voting_power( const name& voter, const asset& total_update );
+         void update_delegated_total( const name& from, const name& receiver, int64_t delta, bool first_delegation );
 
          // defined in voting.cpp
          void register_producer( const name& producer, const eosio::block_signing_authority& producer_authority, const std::string& url, uint16_t location );
          void update_elected_producers( const block_timestamp& timestamp );
-         void update_votes( const name& voter, const name& proxy, const std::vector<name>& producers, bool voting );
-         void propagate_weight_change( const voter_info& voter );
+         void propose_producers( const std::vector<eosio::producer_authority>& producers, const block_timestamp& block_time ); // TELOS
+         void replace_removed_producers( const block_timestamp& block_time ); // TELOS
+         void update_votes( const name& voter, const name& proxy, const std::vector<name>& producers, bool voting, bool recount = false,
+                            producer_vote_deltas* batch = nullptr );
+         void propagate_weight_change( const voter_info& voter, producer_vote_deltas* batch = nullptr );
          double update_producer_votepay_share( const producers_table2::const_iterator& prod_itr,
                                                const time_point& ct,
                                                double shares_rate, bool reset_to_zero = false );
@@ -1741,26 +2137,32 @@ namespace eosiosystem {
          // TELOS BEGIN
          // defined in producer_pay.cpp
          void claimrewards_snapshot();
+         void settle_pay_period( uint32_t max_producers );
          uint64_t get_telos_average_price();
+         uint64_t read_telos_average_price()const;
+         uint64_t peek_telos_average_price()const;
+         tedp_pay_flows get_tedp_pay_flows( bool refresh_price );
 
-         double inverse_vote_weight(double staked, double amountVotedProducers);
+         double inverse_vote_weight(double staked, size_t amountVotedProducers);
          void recalculate_votes();
+         uint32_t repair_votes( uint32_t max_rows );
+         bool is_vote_counted( const name& voter )const;
+         void refresh_vote( const name& voter_name, producer_vote_deltas* batch = nullptr );
 
          //defined in system_kick.cpp
          bool crossed_missed_blocks_threshold(uint32_t amountBlocksMissed, uint32_t schedule_size);
          void reset_schedule_metrics(name producer);
          void update_producer_missed_blocks(name producer);
-         bool is_new_schedule_activated(name active_schedule[], uint32_t size);
-         bool is_new_schedule_activated(std::vector<name>& schedule);
+         bool is_new_schedule_activated(const std::vector<name>& schedule);
          bool check_missed_blocks(block_timestamp timestamp, name producer);
 
          //define in system_rotation.cpp
          void set_bps_rotation(name bpOut, name sbpIn);
          void update_rotation_time(block_timestamp block_time);
          void update_missed_blocks_per_rotation();
-         void restart_missed_blocks_per_rotation(std::vector<producer_location_pair> prods);
+         void restart_missed_blocks_per_rotation(const std::vector<producer_location_pair>& prods);
          bool is_in_range(int32_t index, int32_t low_bound, int32_t up_bound);
-         std::vector<producer_location_pair> check_rotation_state(std::vector<producer_location_pair> producers, block_timestamp block_time);
+         std::vector<uint8_t> check_rotation_state(const std::vector<producer_location_pair>& producers, block_timestamp block_time);
          // TELOS END
    };
 
@@ -4,13 +4,16 @@
 #include <eosio/eosio.hpp>
 #include <eosio/name.hpp>
 
+#include <vector>
+
 using eosio::action_wrapper;
 using eosio::asset;
 using eosio::name;
 
 /**
- * The actions `buyresult`, `sellresult`, `rentresult`, and `orderresult` of `rex.results` are all no-ops.
- * They are added as inline convenience actions to `rentnet`, `rentcpu`, `buyrex`, `unstaketorex`, and `sellrex`.
+ * The actions `buyresult`, `sellresult`, `rentresult`, `orderresult`, `fillresult`, and `execresult` of `rex.results`
+ * are all no-ops. They are added as inline convenience actions to `rentnet`, `rentcpu`, `buyrex`, `unstaketorex`,
+ * `sellrex`, and to the processing of queued sellrex orders and `rexexec`.
  * An inline convenience action does not have any effect, however,
  * its data includes the result of the parent action and appears in its trace.
  */
@@ -19,6 +22,13 @@ class [[eosio::contract("rex.results")]] rex_results : eosio::contract {
 
       using eosio::contract::contract;
 
+      struct order_fill {
+         name  owner;
+         asset proceeds;
+
+         EOSLIB_SERIALIZE( order_fill, (owner)(proceeds) )
+      };
+
       /**
        * Buyresult action.
        *
@@ -44,6 +54,14 @@ class [[eosio::contract("rex.results")]] rex_results : eosio::contract {
       [[eosio::action]]
       void orderresult( const name& owner, const asset& proceeds );
 
+      /**
+       * Fillresult action.
+       *
+       * @param fills - owner and proceeds of each queued sell order filled in one batch
+       */
+      [[eosio::action]]
+      void fillresult( const std::vector<order_fill>& fills );
+
       /**
        * Rentresult action.
        *
@@ -52,8 +70,20 @@ class [[eosio::contract("rex.results")]] rex_results : eosio::contract {
       [[eosio::action]]
       void rentresult( const asset& rented_tokens );
 
+      /**
+       * Execresult action.
+       *
+       * @param cpu_loans - number of expired CPU loans processed
+       * @param net_loans - number of expired NET loans processed
+       * @param sell_orders - number of queued sell orders processed
+       */
+      [[eosio::action]]
+      void execresult( uint16_t cpu_loans, uint16_t net_loans, uint16_t sell_orders );
+
       using buyresult_action   = action_wrapper<"buyresult"_n,   &rex_results::buyresult>;
       using sellresult_action  = action_wrapper<"sellresult"_n,  &rex_results::sellresult>;
       using orderresult_action = action_wrapper<"orderresult"_n, &rex_results::orderresult>;
+      using fillresult_action  = action_wrapper<"fillresult"_n,  &rex_results::fillresult>;
       using rentresult_action  = action_wrapper<"rentresult"_n,  &rex_results::rentresult>;
+      using execresult_action  = action_wrapper<"execresult"_n,  &rex_results::execresult>;
 };
@@ -0,0 +1,55 @@
+#pragma once
+
+// TELOS BEGIN
+#include <cstdint>
+
+namespace eosiosystem {
+
+   /**
+    * Sizes and periods of the producer schedule as compile-time constants, replacing the former schedule macros.
+    *
+    * `TopProducers` producers are scheduled and earn two pay shares each, standbys up to `MaxProducers` earn one share
+    * and rotate in, one at a time, every `RotationIntervalUs`. A producer signs `MaxBlocksPerCycle` blocks in a row.
+    *
+    * The rotation, kick, voting and pay code is not templated on a policy, it reads `active_schedule_policy`, so a
+    * contract build uses exactly one policy. Building with `TELOS_SMALL_SCHEDULE` defined selects
+    * `small_schedule_policy`, for testnets with few producers.
+    */
+   template <uint32_t TopProducers, uint32_t MaxProducers, uint32_t MaxVoteProducers, uint32_t MaxBlocksPerCycle,
+             int64_t RotationIntervalUs>
+   struct schedule_policy {
+      static constexpr uint32_t top_producers        = TopProducers;
+      static constexpr uint32_t max_producers        = MaxProducers;
+      static constexpr uint32_t max_vote_producers   = MaxVoteProducers;
+      static constexpr uint32_t max_blocks_per_cycle = MaxBlocksPerCycle;
+      static constexpr int64_t  rotation_interval_us = RotationIntervalUs;
+
+      static_assert( 0 < top_producers && top_producers <= max_producers, "top producers must fit in the schedule" );
+      static_assert( max_producers < 255, "schedule positions are stored as uint8_t" );
+      static_assert( 1 < max_blocks_per_cycle, "a producer signs more than one block per cycle" );
+
+      /// Pay shares of a period with `active` ranked producers: two per top producer and one per standby.
+      static constexpr uint32_t pay_share_count( uint32_t active ) {
+         return active <= top_producers ? active * 2 : 2 * top_producers + (active - top_producers);
+      }
+
+      /// Pay shares earned by the producer ranked at `position` in a period.
+      static constexpr uint32_t pay_shares( uint32_t position ) {
+         return position < top_producers ? 2 : 1;
+      }
+   };
+
+   using telos_schedule_policy = schedule_policy<21, 42, 30, 12, 43'200'000'000ll>; // 12 hour rotation
+   using small_schedule_policy = schedule_policy<4, 8, 30, 12, 900'000'000ll>;      // 15 minute rotation
+
+   static_assert( telos_schedule_policy::pay_share_count(42) == 63 );
+   static_assert( small_schedule_policy::pay_share_count(3) == 6 );
+
+#ifdef TELOS_SMALL_SCHEDULE
+   using active_schedule_policy = small_schedule_policy;
+#else
+   using active_schedule_policy = telos_schedule_policy;
+#endif
+
+} /// namespace eosiosystem
+// TELOS END
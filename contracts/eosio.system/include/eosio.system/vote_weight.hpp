@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+namespace eosiosystem {
+
+// TELOS BEGIN
+/**
+ * Weight factors applied to a voter's stake by `inverse_vote_weight`, indexed by the number of producers voted for.
+ *
+ * Entry `n` is the exact double produced by the original formula `(sin(M_PI * (n / 30.0) - M_PI_2) + 1.0) / 2.0`,
+ * written out as hexadecimal literals so that no rounding happens on the way in. The table replaces the per-vote
+ * `sin()` call, which has no native implementation under WASM. telos.system_tests.cpp checks every entry bit for bit
+ * against the formula.
+ */
+static constexpr std::array<double, 31> vote_weight_factors = {
+   0x0.0p+0, //  0
+   0x1.6703583cc1d00p-9, //  1
+   0x1.66079b0bff020p-7, //  2
+   0x1.90f1ecbbab010p-6, //  3
+   0x1.621e288040358p-5, //  4
+   0x1.126145e9ecd54p-4, //  5
+   0x1.8722191a02d60p-4, //  6
+   0x1.07050af98827ep-3, //  7
+   0x1.52cf6d23be850p-3, //  8
+   0x1.a61b9f7154b44p-3, //  9
+   0x1.0000000000000p-2, // 10
+   0x1.2fc036f7cf296p-2, // 11
+   0x1.61c8864680b58p-2, // 12
+   0x1.958c994ef69c4p-2, // 13
+   0x1.ca7b3ec987513p-2, // 14
+   0x1.0000000000000p-1, // 15
+   0x1.1ac2609b3c576p-1, // 16
+   0x1.3539b35884b1ep-1, // 17
+   0x1.4f1bbcdcbfa54p-1, // 18
+   0x1.681fe484186b4p-1, // 19
+   0x1.7ffffffffffffp-1, // 20
+   0x1.96791823aad2fp-1, // 21
+   0x1.ab4c24b7105ebp-1, // 22
+   0x1.be3ebd419df62p-1, // 23
+   0x1.cf1bbcdcbfa54p-1, // 24
+   0x1.ddb3d742c2656p-1, // 25
+   0x1.e9de1d77fbfcbp-1, // 26
+   0x1.f378709a22a80p-1, // 27
+   0x1.fa67e193d0040p-1, // 28
+   0x1.fe98fca7c33e3p-1, // 29
+   0x1.0000000000000p+0, // 30
+};
+
+static_assert( vote_weight_factors[0] == 0.0 && vote_weight_factors[10] == 0.25 && vote_weight_factors[15] == 0.5 &&
+               vote_weight_factors[30] == 1.0, "vote weight factors out of sync with the formula" );
+
+constexpr bool vote_weight_factors_increasing() {
+   for( size_t i = 1; i < vote_weight_factors.size(); ++i ) {
+      if( !( vote_weight_factors[i - 1] < vote_weight_factors[i] ) ) {
+         return false;
+      }
+   }
+   return true;
+}
+static_assert( vote_weight_factors_increasing(), "vote weight factors must increase with the number of producers voted" );
+// TELOS END
+
+} /// namespace eosiosystem
@@ -42,6 +42,102 @@ void system_contract::add_to_blockinfo_table(const eosio::checksum256&    previo
    {
       itr = t.erase(itr);
    }
+
+   // TELOS BEGIN
+   // The blockinfo table above holds the default window. The blockring table is only touched once setblockwin has set
+   // a larger window, and until the slots of a shrunk window have been erased.
+   block_info::block_info_window_singleton window_singleton(get_self(), 0);
+   if (window_singleton.exists()) {
+      block_info::block_info_window window    = window_singleton.get();
+      const uint32_t                ring_size = window.ring_size();
+
+      block_info::block_info_ring_table ring(get_self(), 0);
+
+      if (ring_size > 0) {
+         // Record the new block in its slot, overwriting the block that has fallen out of the rolling window.
+         const uint32_t slot = new_block_height % ring_size;
+         auto           itr  = ring.find(slot);
+         if (itr == ring.end()) {
+            ring.emplace(get_self(), [&](block_info::block_info_slot& r) {
+               r.slot            = slot;
+               r.block_height    = new_block_height;
+               r.block_timestamp = new_block_timestamp;
+            });
+         } else {
+            ring.modify(itr, same_payer, [&](block_info::block_info_slot& r) {
+               r.block_height    = new_block_height;
+               r.block_timestamp = new_block_timestamp;
+            });
+         }
+      }
+
+      if (window.shrinking) {
+         // Erase up to two slots beyond the shrunk window; once none are left, the blockinfo table alone holds the
+         // default window again.
+         auto itr = ring.lower_bound(ring_size);
+         for (count = 2; itr != ring.end() && 0 < count; --count) {
+            itr = ring.erase(itr);
+         }
+
+         if (itr == ring.end()) {
+            if (ring_size == 0) {
+               window_singleton.remove();
+            } else {
+               window.shrinking = false;
+               window_singleton.set(window, get_self());
+            }
+         }
+      }
+   }
+
+   // Every checkpoint interval, also record the block in the slot of the oldest checkpoint of that level.
+   for (const auto& level : block_info::checkpoint_levels) {
+      if (new_block_height % level.interval != 0) {
+         continue;
+      }
+
+      block_info::block_checkpoint_table checkpoints(get_self(), level.interval);
+
+      const uint32_t slot = (new_block_height / level.interval) % level.slots;
+      auto           itr  = checkpoints.find(slot);
+      if (itr == checkpoints.end()) {
+         checkpoints.emplace(get_self(), [&](block_info::block_checkpoint& r) {
+            r.slot            = slot;
+            r.block_height    = new_block_height;
+            r.block_timestamp = new_block_timestamp;
+         });
+      } else {
+         checkpoints.modify(itr, same_payer, [&](block_info::block_checkpoint& r) {
+            r.block_height    = new_block_height;
+            r.block_timestamp = new_block_timestamp;
+         });
+      }
+   }
+   // TELOS END
+}
+
+// TELOS BEGIN
+void system_contract::setblockwin(uint32_t window_size)
+{
+   require_auth(get_self());
+
+   check(window_size <= block_info::max_rolling_window_size, "window_size exceeds the maximum rolling window size");
+   check(window_size >= block_info::rolling_window_size, "window_size is below the blockinfo window size");
+
+   block_info::block_info_window_singleton window_singleton(get_self(), 0);
+   block_info::block_info_window           window = window_singleton.get_or_default();
+
+   check(window.window_size != window_size, "window_size is unchanged");
+
+   // Blocks already recorded keep their slots; lookups verify the block height of a slot, so any slot that no longer
+   // matches the new window is simply treated as missing until it is overwritten. Slots beyond a smaller window are
+   // erased by onblock.
+   if (window_size < window.window_size) {
+      window.shrinking = true;
+   }
+   window.window_size = window_size;
+   window_singleton.set(window, get_self());
 }
+// TELOS END
 
 } // namespace eosiosystem
\ No newline at end of file
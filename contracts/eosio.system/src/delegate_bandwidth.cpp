@@ -76,8 +76,8 @@ namespace eosiosystem {
 
       check( bytes_out > 0, "must reserve a positive amount" );
 
-      _gstate.total_ram_bytes_reserved += uint64_t(bytes_out);
-      _gstate.total_ram_stake          += quant_after_fee.amount;
+      _gstate->total_ram_bytes_reserved += uint64_t(bytes_out);
+      _gstate->total_ram_stake          += quant_after_fee.amount;
 
       user_resources_table  userres( get_self(), receiver.value );
       auto res_itr = userres.find( receiver.value );
@@ -128,11 +128,11 @@ namespace eosiosystem {
 
       check( tokens_out.amount > 1, "token amount received from selling ram is too low" );
 
-      _gstate.total_ram_bytes_reserved -= static_cast<decltype(_gstate.total_ram_bytes_reserved)>(bytes); // bytes > 0 is asserted above
-      _gstate.total_ram_stake          -= tokens_out.amount;
+      _gstate->total_ram_bytes_reserved -= static_cast<decltype(_gstate->total_ram_bytes_reserved)>(bytes); // bytes > 0 is asserted above
+      _gstate->total_ram_stake          -= tokens_out.amount;
 
       //// this shouldn't happen, but just in case it does we should prevent it
-      check( _gstate.total_ram_stake >= 0, "error, attempt to unstake more tokens than previously staked" );
+      check( _gstate->total_ram_stake >= 0, "error, attempt to unstake more tokens than previously staked" );
 
       userres.modify( res_itr, account, [&]( auto& res ) {
           res.ram_bytes -= bytes;
@@ -186,6 +186,7 @@ namespace eosiosystem {
       // update stake delegated from "from" to "receiver"
       {
          del_bandwidth_table     del_tbl( get_self(), from.value );
+         const bool first_delegation = del_tbl.begin() == del_tbl.end(); // TELOS
          auto itr = del_tbl.find( receiver.value );
          if( itr == del_tbl.end() ) {
             itr = del_tbl.emplace( from, [&]( auto& dbo ){
@@ -206,6 +207,7 @@ namespace eosiosystem {
          if ( itr->is_empty() ) {
             del_tbl.erase( itr );
          }
+         update_delegated_total( from, receiver, stake_net_delta.amount + stake_cpu_delta.amount, first_delegation ); // TELOS
       } // itr can be invalid, should go out of scope
 
       // update totals of "receiver"
@@ -374,6 +376,76 @@ namespace eosiosystem {
       }
    }
 
+   // TELOS BEGIN
+   void system_contract::update_delegated_total( const name& from, const name& receiver, int64_t delta, bool first_delegation )
+   {
+      delegated_totals_table totals( get_self(), get_self().value );
+      auto itr = totals.find( from.value );
+      if( itr == totals.end() ) {
+         // without a row the total is unknown unless this is the account's first delegation;
+         // older delegators get their total from reconcilebw
+         // billed to `from`, who already pays for the delband row of this delegation
+         if( first_delegation ) {
+            totals.emplace( from, [&]( auto& t ) {
+               t.owner      = from;
+               t.delegated  = delta;
+               t.reconciled = true;
+            });
+         }
+         return;
+      }
+
+      // while reconciling, delegations at or past the cursor are summed when the cursor reaches them
+      if( itr->reconciled || receiver.value < itr->next_receiver.value ) {
+         // a reconciled total of zero means the delband table is empty again
+         if( itr->reconciled && itr->delegated + delta == 0 ) {
+            totals.erase( itr );
+            return;
+         }
+         totals.modify( itr, same_payer, [&]( auto& t ) {
+            t.delegated += delta;
+         });
+      }
+   }
+
+   void system_contract::reconcilebw( const name& owner, uint16_t max )
+   {
+      require_auth( get_self() );
+      check( max > 0, "max must be greater than 0" );
+
+      delegated_totals_table totals( get_self(), get_self().value );
+      auto itr = totals.find( owner.value );
+      if( itr == totals.end() ) {
+         itr = totals.emplace( get_self(), [&]( auto& t ) {
+            t.owner = owner;
+         });
+      } else if( itr->reconciled ) {
+         totals.modify( itr, same_payer, [&]( auto& t ) {
+            t.delegated     = 0;
+            t.next_receiver = name(0);
+            t.reconciled    = false;
+         });
+      }
+
+      del_bandwidth_table del_tbl( get_self(), owner.value );
+      auto del_itr = del_tbl.lower_bound( itr->next_receiver.value );
+      int64_t delegated = 0;
+      for( uint16_t i = 0; i < max && del_itr != del_tbl.end(); ++i, ++del_itr ) {
+         delegated += del_itr->net_weight.amount + del_itr->cpu_weight.amount;
+      }
+
+      totals.modify( itr, same_payer, [&]( auto& t ) {
+         t.delegated += delegated;
+         if( del_itr == del_tbl.end() ) {
+            t.next_receiver = name(0);
+            t.reconciled    = true;
+         } else {
+            t.next_receiver = del_itr->to;
+         }
+      });
+   }
+   // TELOS END
+
    void system_contract::delegatebw( const name& from, const name& receiver,
                                      const asset& stake_net_quantity,
                                      const asset& stake_cpu_quantity, bool transfer )
@@ -400,7 +472,7 @@ namespace eosiosystem {
       check( unstake_cpu_quantity >= zero_asset, "must unstake a positive amount" );
       check( unstake_net_quantity >= zero_asset, "must unstake a positive amount" );
       check( unstake_cpu_quantity.amount + unstake_net_quantity.amount > 0, "must unstake a positive amount" );
-      check( _gstate.block_num > block_num_network_activation || _gstate.thresh_activated_stake_time > time_point(),
+      check( _gstate->block_num > block_num_network_activation || _gstate->thresh_activated_stake_time > time_point(),
                     "cannot undelegate bandwidth until the chain is activated (1,000,000 blocks produced)" );
 
       changebw( from, receiver, -unstake_net_quantity, -unstake_cpu_quantity, false);
@@ -20,10 +20,10 @@ namespace eosiosystem {
     _voters(get_self(), get_self().value),
     _producers(get_self(), get_self().value),
     _producers2(get_self(), get_self().value),
-    _global(get_self(), get_self().value),
-    _global2(get_self(), get_self().value),
-    _global3(get_self(), get_self().value),
-    _global4(get_self(), get_self().value),
+    _gstate(get_self(), get_self().value, &system_contract::get_default_parameters),
+    _gstate2(get_self(), get_self().value, []{ return eosio_global_state2{}; }),
+    _gstate3(get_self(), get_self().value, []{ return eosio_global_state3{}; }),
+    _gstate4(get_self(), get_self().value, &system_contract::get_default_inflation_parameters),
     _rammarket(get_self(), get_self().value),
     _rexpool(get_self(), get_self().value),
     _rexretpool(get_self(), get_self().value),
@@ -32,21 +32,18 @@ namespace eosiosystem {
     _rexbalance(get_self(), get_self().value),
     _rexorders(get_self(), get_self().value),
     // TELOS BEGIN
-    _schedule_metrics(_self, _self.value),
-    _rotation(_self, _self.value),
-    _payrate(_self, _self.value),
-    _payments(_self, _self.value)
+    _gschedule_metrics(_self, _self.value, []{ return schedule_metrics_state{ name(0), 0, std::vector<producer_metric>() }; }),
+    _grotation(_self, _self.value, []{ return rotation_state{ name(0), name(0), active_schedule_policy::top_producers, 75, block_timestamp(), block_timestamp() }; }),
+    _gpayrate(_self, _self.value, []{ return payrates{ max_bpay_rate, max_worker_monthly_amount }; }),
+    _gvoterepair(_self, _self.value, []{ return vote_repair_state{}; }),
+    _gpayperiod(_self, _self.value, []{ return pay_period_state{}; }),
+    _gtlosprice(_self, _self.value, []{ return tlos_price_state{}; }),
+    _grexmaint(_self, _self.value, []{ return rex_maintenance_state{}; }),
+    _payments(_self, _self.value),
+    _autopay(_self, _self.value)
     // TELOS END
    {
-      _gstate  = _global.exists() ? _global.get() : get_default_parameters();
-      _gstate2 = _global2.exists() ? _global2.get() : eosio_global_state2{};
-      _gstate3 = _global3.exists() ? _global3.get() : eosio_global_state3{};
-      _gstate4 = _global4.exists() ? _global4.get() : get_default_inflation_parameters();
-      // TELOS BEGIN
-      _gschedule_metrics = _schedule_metrics.get_or_create(_self, schedule_metrics_state{ name(0), 0, std::vector<producer_metric>() });
-      _grotation = _rotation.get_or_create(_self, rotation_state{ name(0), name(0), 21, 75, block_timestamp(), block_timestamp() });
-      _gpayrate = _payrate.get_or_create(_self, payrates{ max_bpay_rate, max_worker_monthly_amount });
-      // TELOS END
+      // singletons are read on first use, see cached_singleton
    }
 
    eosio_global_state system_contract::get_default_parameters() {
@@ -69,25 +66,29 @@ namespace eosiosystem {
    }
 
    system_contract::~system_contract() {
-      _global.set( _gstate, get_self() );
-      _global2.set( _gstate2, get_self() );
-      _global3.set( _gstate3, get_self() );
-      _global4.set( _gstate4, get_self() );
+      _gstate.save( get_self() );
+      _gstate2.save( get_self() );
+      _gstate3.save( get_self() );
+      _gstate4.save( get_self() );
       // TELOS BEGIN
-      _schedule_metrics.set(_gschedule_metrics, _self);
-      _rotation.set(_grotation, _self);
-      _payrate.set(_gpayrate, _self);
+      _gschedule_metrics.save(_self);
+      _grotation.save(_self);
+      _gpayrate.save(_self);
+      _gvoterepair.save(_self);
+      _gpayperiod.save(_self);
+      _gtlosprice.save(_self);
+      _grexmaint.save(_self);
       // TELOS END
    }
 
    void system_contract::setram( uint64_t max_ram_size ) {
       require_auth( get_self() );
 
-      check( _gstate.max_ram_size < max_ram_size, "ram may only be increased" ); /// decreasing ram might result market maker issues
+      check( _gstate->max_ram_size < max_ram_size, "ram may only be increased" ); /// decreasing ram might result market maker issues
       check( max_ram_size < 1024ll*1024*1024*1024*1024, "ram size is unrealistic" );
-      check( max_ram_size > _gstate.total_ram_bytes_reserved, "attempt to set max below reserved" );
+      check( max_ram_size > _gstate->total_ram_bytes_reserved, "attempt to set max below reserved" );
 
-      auto delta = int64_t(max_ram_size) - int64_t(_gstate.max_ram_size);
+      auto delta = int64_t(max_ram_size) - int64_t(_gstate->max_ram_size);
       auto itr = _rammarket.find(ramcore_symbol.raw());
 
       /**
@@ -97,17 +98,17 @@ namespace eosiosystem {
          m.base.balance.amount += delta;
       });
 
-      _gstate.max_ram_size = max_ram_size;
+      _gstate->max_ram_size = max_ram_size;
    }
 
    void system_contract::update_ram_supply() {
       auto cbt = eosio::current_block_time();
 
-      if( cbt <= _gstate2.last_ram_increase ) return;
+      if( cbt <= _gstate2->last_ram_increase ) return;
 
       auto itr = _rammarket.find(ramcore_symbol.raw());
-      auto new_ram = (cbt.slot - _gstate2.last_ram_increase.slot)*_gstate2.new_ram_per_block;
-      _gstate.max_ram_size += new_ram;
+      auto new_ram = (cbt.slot - _gstate2->last_ram_increase.slot)*_gstate2->new_ram_per_block;
+      _gstate->max_ram_size += new_ram;
 
       /**
        *  Increase the amount of ram for sale based upon the change in max ram size.
@@ -115,14 +116,14 @@ namespace eosiosystem {
       _rammarket.modify( itr, same_payer, [&]( auto& m ) {
          m.base.balance.amount += new_ram;
       });
-      _gstate2.last_ram_increase = cbt;
+      _gstate2->last_ram_increase = cbt;
    }
 
    void system_contract::setramrate( uint16_t bytes_per_block ) {
       require_auth( get_self() );
 
       update_ram_supply();
-      _gstate2.new_ram_per_block = bytes_per_block;
+      _gstate2->new_ram_per_block = bytes_per_block;
    }
 
 #ifdef SYSTEM_BLOCKCHAIN_PARAMETERS
@@ -131,8 +132,8 @@ namespace eosiosystem {
 
    void system_contract::setparams( const blockchain_parameters_t& params ) {
       require_auth( get_self() );
-      (eosio::blockchain_parameters&)(_gstate) = params;
-      check( 3 <= _gstate.max_authority_depth, "max_authority_depth should be at least 3" );
+      (eosio::blockchain_parameters&)(*_gstate) = params;
+      check( 3 <= _gstate->max_authority_depth, "max_authority_depth should be at least 3" );
 #ifndef SYSTEM_BLOCKCHAIN_PARAMETERS
       set_blockchain_parameters( params );
 #else
@@ -417,11 +418,11 @@ namespace eosiosystem {
 
    void system_contract::updtrevision( uint8_t revision ) {
       require_auth( get_self() );
-      check( _gstate2.revision < 255, "can not increment revision" ); // prevent wrap around
-      check( revision == _gstate2.revision + 1, "can only increment revision by one" );
+      check( _gstate2->revision < 255, "can not increment revision" ); // prevent wrap around
+      check( revision == _gstate2->revision + 1, "can only increment revision by one" );
       check( revision <= 1, // set upper bound to greatest revision supported in the code
              "specified revision is not yet supported by the code" );
-      _gstate2.revision = revision;
+      _gstate2->revision = revision;
    }
 
    void system_contract::setinflation( int64_t annual_rate, int64_t inflation_pay_factor, int64_t votepay_factor ) {
@@ -433,10 +434,9 @@ namespace eosiosystem {
       if ( votepay_factor < pay_factor_precision ) {
          check( false, "votepay_factor must not be less than " + std::to_string(pay_factor_precision) );
       }
-      _gstate4.continuous_rate      = get_continuous_rate(annual_rate);
-      _gstate4.inflation_pay_factor = inflation_pay_factor;
-      _gstate4.votepay_factor       = votepay_factor;
-      _global4.set( _gstate4, get_self() );
+      _gstate4->continuous_rate      = get_continuous_rate(annual_rate);
+      _gstate4->inflation_pay_factor = inflation_pay_factor;
+      _gstate4->votepay_factor       = votepay_factor;
    }
 
    /**
@@ -517,7 +517,7 @@ namespace eosiosystem {
       _rammarket.emplace( get_self(), [&]( auto& m ) {
          m.supply.amount = 100000000000000ll;
          m.supply.symbol = ramcore_symbol;
-         m.base.balance.amount = int64_t(_gstate.free_ram());
+         m.base.balance.amount = int64_t(_gstate->free_ram());
          m.base.balance.symbol = ram_symbol;
          m.quote.balance.amount = system_token_supply.amount / 1000;
          m.quote.balance.symbol = core;
@@ -544,8 +544,8 @@ namespace eosiosystem {
       require_auth(_self);
       check(worker <= max_worker_monthly_amount, "WPS rate exceeds the max");
       check(bpay <= max_bpay_rate, "BPAY rate exceeds the max");
-      _gpayrate.bpay_rate = bpay;
-      _gpayrate.worker_amount = worker;
+      _gpayrate->bpay_rate = bpay;
+      _gpayrate->worker_amount = worker;
    }
 
    void system_contract::distviarex(name from, asset amount) {
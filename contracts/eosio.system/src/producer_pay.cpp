@@ -4,7 +4,6 @@
 #include <eosio.tedp/eosio.tedp.hpp>
 #include <delphioracle/delphioracle.hpp>
 #include "system_kick.cpp"
-#define MAX_PRODUCERS 42     // revised for TEDP 2 Phase 2, also set in system_rotation.cpp, change in both places
 // TELOS END
 
 namespace eosiosystem {
@@ -30,25 +29,25 @@ namespace eosiosystem {
       // Add latest block information to blockinfo table.
       add_to_blockinfo_table(previous_block_id, timestamp);
 
-      // _gstate2.last_block_num is not used anywhere in the system contract code anymore.
+      // _gstate2->last_block_num is not used anywhere in the system contract code anymore.
       // Although this field is deprecated, we will continue updating it for now until the last_block_num field
       // is eventually completely removed, at which point this line can be removed.
-      _gstate2.last_block_num = timestamp;
+      _gstate2->last_block_num = timestamp;
 
       /** until activation, no new rewards are paid */
       // TELOS BEGIN
-      _gstate.block_num++;
-      if (_gstate.thresh_activated_stake_time == time_point()) {
-          if(_gstate.block_num >= block_num_network_activation && _gstate.total_producer_vote_weight > 0) {
-              _gstate.thresh_activated_stake_time = current_time_point();
-              _gstate.last_claimrewards = timestamp.slot;
+      _gstate->block_num++;
+      if (_gstate->thresh_activated_stake_time == time_point()) {
+          if(_gstate->block_num >= block_num_network_activation && _gstate->total_producer_vote_weight > 0) {
+              _gstate->thresh_activated_stake_time = current_time_point();
+              _gstate->last_claimrewards = timestamp.slot;
           }
           return;
       }
       // TELOS END
 
-      if( _gstate.last_pervote_bucket_fill == time_point() )  /// start the presses
-         _gstate.last_pervote_bucket_fill = current_time_point();
+      if( _gstate->last_pervote_bucket_fill == time_point() )  /// start the presses
+         _gstate->last_pervote_bucket_fill = current_time_point();
 
       // TELOS BEGIN
       if(check_missed_blocks(timestamp, producer)) {
@@ -63,7 +62,7 @@ namespace eosiosystem {
        */
       auto prod = _producers.find( producer.value );
       if ( prod != _producers.end() ) {
-         _gstate.total_unpaid_blocks++;
+         _gstate->total_unpaid_blocks++;
          _producers.modify( prod, same_payer, [&](auto& p ) {
                p.unpaid_blocks++;
                p.lifetime_produced_blocks++;  // TELOS
@@ -73,20 +72,20 @@ namespace eosiosystem {
       recalculate_votes();  // TELOS
 
       /// only update block producers once every minute, block_timestamp is in half seconds
-      if( timestamp.slot - _gstate.last_producer_schedule_update.slot > 120 ) {
+      if( timestamp.slot - _gstate->last_producer_schedule_update.slot > 120 ) {
          update_elected_producers( timestamp );
 
-         if( (timestamp.slot - _gstate.last_name_close.slot) > blocks_per_day ) {
+         if( (timestamp.slot - _gstate->last_name_close.slot) > blocks_per_day ) {
             name_bid_table bids(get_self(), get_self().value);
             auto idx = bids.get_index<"highbid"_n>();
             auto highest = idx.lower_bound( std::numeric_limits<uint64_t>::max()/2 );
             if( highest != idx.end() &&
                 highest->high_bid > 0 &&
                 (current_time_point() - highest->last_bid_time) > microseconds(useconds_per_day) &&
-                _gstate.thresh_activated_stake_time > time_point() &&
-                (current_time_point() - _gstate.thresh_activated_stake_time) > microseconds(14 * useconds_per_day)
+                _gstate->thresh_activated_stake_time > time_point() &&
+                (current_time_point() - _gstate->thresh_activated_stake_time) > microseconds(14 * useconds_per_day)
             ) {
-               _gstate.last_name_close = timestamp;
+               _gstate->last_name_close = timestamp;
                channel_namebid_to_rex( highest->high_bid );
                idx.modify( highest, same_payer, [&]( auto& b ){
                   b.high_bid = -b.high_bid;
@@ -95,10 +94,14 @@ namespace eosiosystem {
          }
       }
       // TELOS BEGIN
-      //called once per day to set payments snapshot
-      if (_gstate.last_claimrewards + uint32_t(3600) <= timestamp.slot) { //172800 blocks in a day
+      //called once per day to set payments snapshot, held back while producer totals are being recounted
+      if (!_gvoterepair->in_progress() && _gstate->last_claimrewards + uint32_t(3600) <= timestamp.slot) { //172800 blocks in a day
           claimrewards_snapshot();
-          _gstate.last_claimrewards = timestamp.slot;
+          _gstate->last_claimrewards = timestamp.slot;
+      }
+
+      if (_gpayperiod->pending()) {
+          settle_pay_period(pay_period_state::settle_per_block);
       }
       // TELOS END
    }
@@ -110,9 +113,13 @@ namespace eosiosystem {
       check( prod.active(), "producer does not have an active key" );
 
       // TELOS BEGIN
-      check( _gstate.thresh_activated_stake_time > time_point(),
+      check( _gstate->thresh_activated_stake_time > time_point(),
               "cannot claim rewards until the chain is activated (1,000,000 blocks produced)");
 
+      if (_gpayperiod->pending()) {
+          settle_pay_period(_gpayperiod->ranked.size());
+      }
+
       auto p = _payments.find(owner.value);
       check(p != _payments.end(), "No payment exists for account");
       auto prod_payment = *p;
@@ -134,17 +141,17 @@ namespace eosiosystem {
       check( ct - prod.last_claim_time > microseconds(useconds_per_day), "already claimed rewards within past day" );
 
       const asset token_supply   = token::get_supply(token_account, core_symbol().code() );
-      const auto usecs_since_last_fill = (ct - _gstate.last_pervote_bucket_fill).count();
+      const auto usecs_since_last_fill = (ct - _gstate->last_pervote_bucket_fill).count();
 
-      if( usecs_since_last_fill > 0 && _gstate.last_pervote_bucket_fill > time_point() ) {
-         double additional_inflation = (_gstate4.continuous_rate * double(token_supply.amount) * double(usecs_since_last_fill)) / double(useconds_per_year);
+      if( usecs_since_last_fill > 0 && _gstate->last_pervote_bucket_fill > time_point() ) {
+         double additional_inflation = (_gstate4->continuous_rate * double(token_supply.amount) * double(usecs_since_last_fill)) / double(useconds_per_year);
          check( additional_inflation <= double(std::numeric_limits<int64_t>::max() - ((1ll << 10) - 1)),
                 "overflow in calculating new tokens to be issued; inflation rate is too high" );
          int64_t new_tokens = (additional_inflation < 0.0) ? 0 : static_cast<int64_t>(additional_inflation);
 
-         int64_t to_producers     = (new_tokens * uint128_t(pay_factor_precision)) / _gstate4.inflation_pay_factor;
+         int64_t to_producers     = (new_tokens * uint128_t(pay_factor_precision)) / _gstate4->inflation_pay_factor;
          int64_t to_savings       = new_tokens - to_producers;
-         int64_t to_per_block_pay = (to_producers * uint128_t(pay_factor_precision)) / _gstate4.votepay_factor;
+         int64_t to_per_block_pay = (to_producers * uint128_t(pay_factor_precision)) / _gstate4->votepay_factor;
          int64_t to_per_vote_pay  = to_producers - to_per_block_pay;
 
          if( new_tokens > 0 ) {
@@ -166,9 +173,9 @@ namespace eosiosystem {
             }
          }
 
-         _gstate.pervote_bucket          += to_per_vote_pay;
-         _gstate.perblock_bucket         += to_per_block_pay;
-         _gstate.last_pervote_bucket_fill = ct;
+         _gstate->pervote_bucket          += to_per_vote_pay;
+         _gstate->perblock_bucket         += to_per_block_pay;
+         _gstate->last_pervote_bucket_fill = ct;
       }
 
       auto prod2 = _producers2.find( owner.value );
@@ -194,8 +201,8 @@ namespace eosiosystem {
       // In fact it is desired behavior because the producers votes need to be counted in the global total_producer_votepay_share for the first time.
 
       int64_t producer_per_block_pay = 0;
-      if( _gstate.total_unpaid_blocks > 0 ) {
-         producer_per_block_pay = (_gstate.perblock_bucket * prod.unpaid_blocks) / _gstate.total_unpaid_blocks;
+      if( _gstate->total_unpaid_blocks > 0 ) {
+         producer_per_block_pay = (_gstate->perblock_bucket * prod.unpaid_blocks) / _gstate->total_unpaid_blocks;
       }
 
       double new_votepay_share = update_producer_votepay_share( prod2,
@@ -205,16 +212,16 @@ namespace eosiosystem {
                                  );
 
       int64_t producer_per_vote_pay = 0;
-      if( _gstate2.revision > 0 ) {
+      if( _gstate2->revision > 0 ) {
          double total_votepay_share = update_total_votepay_share( ct );
          if( total_votepay_share > 0 && !crossed_threshold ) {
-            producer_per_vote_pay = int64_t((new_votepay_share * _gstate.pervote_bucket) / total_votepay_share);
-            if( producer_per_vote_pay > _gstate.pervote_bucket )
-               producer_per_vote_pay = _gstate.pervote_bucket;
+            producer_per_vote_pay = int64_t((new_votepay_share * _gstate->pervote_bucket) / total_votepay_share);
+            if( producer_per_vote_pay > _gstate->pervote_bucket )
+               producer_per_vote_pay = _gstate->pervote_bucket;
          }
       } else {
-         if( _gstate.total_producer_vote_weight > 0 ) {
-            producer_per_vote_pay = int64_t((_gstate.pervote_bucket * prod.total_votes) / _gstate.total_producer_vote_weight);
+         if( _gstate->total_producer_vote_weight > 0 ) {
+            producer_per_vote_pay = int64_t((_gstate->pervote_bucket * prod.total_votes) / _gstate->total_producer_vote_weight);
          }
       }
 
@@ -222,9 +229,9 @@ namespace eosiosystem {
          producer_per_vote_pay = 0;
       }
 
-      _gstate.pervote_bucket      -= producer_per_vote_pay;
-      _gstate.perblock_bucket     -= producer_per_block_pay;
-      _gstate.total_unpaid_blocks -= prod.unpaid_blocks;
+      _gstate->pervote_bucket      -= producer_per_vote_pay;
+      _gstate->perblock_bucket     -= producer_per_block_pay;
+      _gstate->total_unpaid_blocks -= prod.unpaid_blocks;
 
       update_total_votepay_share( ct, -new_votepay_share, (updated_after_threshold ? prod.total_votes : 0.0) );
 
@@ -246,52 +253,74 @@ namespace eosiosystem {
 
    // TELOS BEGIN
    uint64_t system_contract::get_telos_average_price() {
-      // Reads the delphi oracle TLOS/USD price
-      delphioracle::averagestable averages_table(delphi_oracle_account, "tlosusd"_n.value);
+      const auto ct = current_time_point();
+      if (_gtlosprice->price == 0 || ct >= _gtlosprice->updated_at + microseconds(tlos_price_state::refresh_interval_us)) {
+         _gtlosprice->price = read_telos_average_price();
+         _gtlosprice->updated_at = ct;
+      }
+      return _gtlosprice->price;
+   }
 
-      // Gets monthly average TLOS price
-      for (auto itr = averages_table.begin(); itr != averages_table.end(); ++itr) {
-         if (itr->type == delphioracle::averages::get_type(average_types::last_30_days)) {
-            return itr->value;
+   uint64_t system_contract::peek_telos_average_price()const {
+      // Same price get_telos_average_price returns, without refreshing the cached one
+      tlos_price_singleton cache(get_self(), get_self().value);
+      if (cache.exists()) {
+         const auto state = cache.get();
+         if (state.price > 0 && current_time_point() < state.updated_at + microseconds(tlos_price_state::refresh_interval_us)) {
+            return state.price;
          }
       }
+      return read_telos_average_price();
+   }
 
-      // Gets 14 days average if monthly average is not available
-      for (auto itr = averages_table.begin(); itr != averages_table.end(); ++itr) {
-         if (itr->type == delphioracle::averages::get_type(average_types::last_14_days)) {
-            return itr->value;
+   uint64_t system_contract::read_telos_average_price()const {
+      // Reads the delphi oracle TLOS/USD price
+      delphioracle::averagestable averages_table(delphi_oracle_account, "tlosusd"_n.value);
+
+      // Prefers the monthly average, then the 14 days and the 7 days averages, in a single pass
+      const uint8_t preferred[] = {
+         delphioracle::averages::get_type(average_types::last_30_days),
+         delphioracle::averages::get_type(average_types::last_14_days),
+         delphioracle::averages::get_type(average_types::last_7_days)
+      };
+      uint64_t found[] = { 0, 0, 0 };
+      bool seen[] = { false, false, false };
+
+      for (auto itr = averages_table.begin(); itr != averages_table.end() && !seen[0]; ++itr) {
+         for (size_t i = 0; i < 3; ++i) {
+            if (itr->type == preferred[i] && !seen[i]) {
+               found[i] = itr->value;
+               seen[i] = true;
+            }
          }
       }
 
-      // Gets 7 days average if 14 days average is not available
-      for (auto itr = averages_table.begin(); itr != averages_table.end(); ++itr) {
-         if (itr->type == delphioracle::averages::get_type(average_types::last_7_days)) {
-            return itr->value;
-         }
+      for (size_t i = 0; i < 3; ++i) {
+         if (seen[i]) return found[i];
       }
-      
+
       // Returns smallest non zero value if no price is available
       return 1;
    }
    // TELOS END
 
    void system_contract::claimrewards_snapshot() {
-        check(_gstate.thresh_activated_stake_time > time_point(), "cannot take snapshot until chain is activated");
+        check(_gstate->thresh_activated_stake_time > time_point(), "cannot take snapshot until chain is activated");
 
         //skips action, since there are no rewards to claim
-        if (_gstate.total_unpaid_blocks <= 0) { 
+        if (_gstate->total_unpaid_blocks <= 0) { 
             return;
         }
 
         auto ct = current_time_point();
 
-        const auto usecs_since_last_fill = (ct - _gstate.last_pervote_bucket_fill).count();
+        const auto usecs_since_last_fill = (ct - _gstate->last_pervote_bucket_fill).count();
 
-        if (usecs_since_last_fill > 0 && _gstate.last_pervote_bucket_fill > time_point())
+        if (usecs_since_last_fill > 0 && _gstate->last_pervote_bucket_fill > time_point())
         {
             // TELOS BEGIN
             uint64_t tlos_price = get_telos_average_price();
-            auto to_workers = static_cast<int64_t>((12 * double(_gpayrate.worker_amount) * double(usecs_since_last_fill)) / double(useconds_per_year));
+            auto to_workers = static_cast<int64_t>((12 * double(_gpayrate->worker_amount) * double(usecs_since_last_fill)) / double(useconds_per_year));
             double bp_pay_per_month = std::min((double(378000) * std::pow(tlos_price/10000.0,-0.516)),double(882000)) * 10000;
             auto to_producers = static_cast<int64_t>((bp_pay_per_month * 12 * double(usecs_since_last_fill)) / double(useconds_per_year));
             // TELOS END
@@ -333,136 +362,218 @@ namespace eosiosystem {
                 transfer_act.send(get_self(), bpay_account, asset(to_producers, core_symbol()), "Transfer producer share to per-block bucket");
             }
 
-            _gstate.perblock_bucket += to_producers;
-            _gstate.last_pervote_bucket_fill = ct;
+            _gstate->perblock_bucket += to_producers;
+            _gstate->last_pervote_bucket_fill = ct;
+        }
+
+        // credit what is left of the previous period before its ranking is replaced
+        if (_gpayperiod->pending()) {
+            settle_pay_period(_gpayperiod->ranked.size());
         }
 
         //sort producers table
         auto sortedprods = _producers.get_index<"prototalvote"_n>();
 
-        //calculate shares, based on MAX_PRODUCERS
+        // rank the producers to pay in one pass; the share count only counts the active producers
+        // ahead of the first inactive one, based on active_schedule_policy::max_producers
+        std::vector<name> ranked;
+        ranked.reserve(active_schedule_policy::max_producers);
         uint32_t activecount = 0;
+        bool counting = true;
 
-        for (const auto &prod : sortedprods)
-        {
-            if (prod.active() && activecount < MAX_PRODUCERS)   //only count activated producers
-                activecount++;
-            else
+        for (const auto &prod : sortedprods) {
+            if (ranked.size() >= active_schedule_policy::max_producers || prod.by_votes() > 0) //no active producer sorts past a voted inactive one
                 break;
+
+            if (!prod.active()) { //skip inactive producers
+                counting = false;
+                continue;
+            }
+
+            if (counting)
+                activecount++;
+            ranked.push_back(prod.owner);
         }
 
         // if we don't have standbys (21 active or less), don't attempt to calculate for standbys, just do total activecount X 2
         // if we have standbys, do 42 shares for the top 21 plus 1 share per standby, so 42 plus the total activecount minus 21
-        uint32_t sharecount = activecount <= 21 ? (activecount * 2) : (42 + (activecount - 21));
-
-        auto shareValue = (_gstate.perblock_bucket / sharecount);
-        int32_t index = 0;
-
-        for (const auto &prod : sortedprods) {
-
-            if (!prod.active()) //skip inactive producers
-                continue;
+        // (21 being active_schedule_policy::top_producers)
+        uint32_t sharecount = active_schedule_policy::pay_share_count(activecount);
+        if (sharecount == 0)
+            return;
 
-            int64_t pay_amount = 0;
-            index++;
+        auto shareValue = (_gstate->perblock_bucket / sharecount);
+        _gstate->perblock_bucket -= shareValue * int64_t(active_schedule_policy::pay_share_count(ranked.size()));
 
-            if (index <= 21) {
-                pay_amount = (shareValue * int64_t(2));
-            } else if (index >= 22 && index <= MAX_PRODUCERS) {
-                pay_amount = shareValue;
-            } else 
-                break;
-
-            _gstate.perblock_bucket -= pay_amount;
-            _gstate.total_unpaid_blocks -= prod.unpaid_blocks;
+        // the ranked producers are paid for their blocks so far, later blocks count towards the next period
+        for (const name& owner : ranked) {
+            const auto& prod = _producers.get(owner.value);
+            _gstate->total_unpaid_blocks -= prod.unpaid_blocks;
 
             _producers.modify(prod, same_payer, [&](auto &p) {
                 p.last_claim_time = ct;
                 p.unpaid_blocks = 0;
             });
-
-            auto itr = _payments.find(prod.owner.value);
-
-            if (itr == _payments.end()) {
-                _payments.emplace(_self, [&]( auto& a ) { 
-                    a.bp = prod.owner;
-                    a.pay = asset(pay_amount, core_symbol());
-                });
-            } else //adds new payment to existing payment
-                _payments.modify(itr, same_payer, [&]( auto& a ) {
-                    a.pay += asset(pay_amount, core_symbol());
-                });
         }
+
+        // the payments rows are credited from this ranking by settle_pay_period
+        _gpayperiod->closed_at = ct;
+        _gpayperiod->share_value = shareValue;
+        _gpayperiod->ranked = std::move(ranked);
+        _gpayperiod->cursor = 0;
     }
 
    // TELOS BEGIN
-   void system_contract::pay() {
-      // Reads the payouts table
-      tedp::payout_table payouts(tedp_account, tedp_account.value);
+   void system_contract::settle_pay_period( uint32_t max_producers ) {
+      auto& period = *_gpayperiod;
+
+      for (uint32_t n = 0; n < max_producers && period.pending(); ++n, ++period.cursor) {
+         const name owner = period.ranked[period.cursor];
+         const int64_t pay_amount = period.share_value * int64_t(active_schedule_policy::pay_shares(period.cursor));
+
+         auto itr = _payments.find(owner.value);
+
+         // opted in producers are paid now, along with any pay they have not claimed yet; a producer that has since
+         // deployed code is credited instead, so a rejected transfer cannot stall the settlement
+         if (_autopay.find(owner.value) != _autopay.end() && eosio::get_code_hash(owner) == eosio::checksum256()) {
+            asset total_pay(pay_amount, core_symbol());
+            if (itr != _payments.end()) {
+               total_pay += itr->pay;
+               _payments.erase(itr);
+            }
 
-      // Gets daily median TLOS price
-      uint64_t tlos_price = get_telos_average_price();
+            // a period whose shares are worth nothing leaves nothing to transfer
+            if (total_pay.amount > 0) {
+               token::transfer_action transfer_act{ token_account, { bpay_account, active_permission } };
+               transfer_act.send( bpay_account, owner, total_pay, "Producer/Standby Payment" );
+            }
+            continue;
+         }
+
+         if (itr == _payments.end()) {
+            _payments.emplace(_self, [&]( auto& a ) {
+               a.bp = owner;
+               a.pay = asset(pay_amount, core_symbol());
+            });
+         } else //adds new payment to existing payment
+            _payments.modify(itr, same_payer, [&]( auto& a ) {
+               a.pay += asset(pay_amount, core_symbol());
+            });
+      }
+
+      // a settled period only needs its share value, drop the ranking to keep the row small
+      if (!period.pending()) {
+         period.ranked.clear();
+         period.cursor = 0;
+      }
+   }
+
+   void system_contract::settlepay( uint16_t max ) {
+      check( _gpayperiod->pending(), "no producer pay to settle" );
+      check( max > 0, "max must be greater than 0" );
+      settle_pay_period( max );
+   }
+
+   void system_contract::setautopay( const name& producer, bool enabled ) {
+      require_auth( producer );
+      _producers.get( producer.value, "producer not found" );
+
+      auto itr = _autopay.find( producer.value );
+      if (enabled) {
+         check( itr == _autopay.end(), "auto payout is already enabled" );
+         check( eosio::get_code_hash( producer ) == eosio::checksum256(), "auto payout account cannot have contract code" );
+         _autopay.emplace( producer, [&]( auto& a ) {
+            a.producer = producer;
+         });
+      } else {
+         check( itr != _autopay.end(), "auto payout is not enabled" );
+         _autopay.erase( itr );
+      }
+   }
+   // TELOS END
 
-      uint64_t now_ms = current_time_point().sec_since_epoch();
-      bool payouts_made = false;
-      int64_t new_tokens = 0;
+   // TELOS BEGIN
+   tedp_pay_flows system_contract::get_tedp_pay_flows( bool refresh_price ) {
+      // Reads the payouts table on every call, eosio.tedp can add payouts or change their amounts at any time
+      tedp::payout_table payouts(tedp_account, tedp_account.value);
+
+      const uint32_t now = current_time_point().sec_since_epoch();
+      tedp_pay_flows flows{ asset(0, core_symbol()), asset(0, core_symbol()), asset(0, core_symbol()) };
+      flows.next_due = time_point_sec(std::numeric_limits<uint32_t>::max());
+      uint64_t rex_due = 0;
 
       for (auto itr = payouts.begin(); itr != payouts.end(); itr++)
       {
-         auto p = *itr;
+         if (itr->amount == 0)
+            continue;
 
-         uint64_t time_since_last_payout = now_ms - p.last_payout;
+         uint64_t time_since_last_payout = now - itr->last_payout;
+         uint64_t payouts_due = time_since_last_payout / itr->interval;
 
-         uint64_t payouts_due = time_since_last_payout / p.interval;
+         // No payout can be due before the next interval of this one ends
+         const uint64_t next_due = itr->last_payout + (payouts_due + 1) * itr->interval;
+         if (next_due < flows.next_due.utc_seconds) {
+            flows.next_due = time_point_sec(static_cast<uint32_t>(next_due));
+         }
 
          if (payouts_due == 0)
             continue;
 
-         if (p.amount == 0)
-            continue;
-
-         uint64_t total_due = (payouts_due * p.amount) * 10000;
-         payouts_made = true;
-
-         if (p.to == REX_ACCOUNT)
-         {
-            uint64_t payout = total_due;
-            if(tlos_price >= 10000 && tlos_price < 20000) { // If TLOS daily close of $1.00, the payout will be decreased to 2/3
-               payout *= 2;
-               payout /= 3;
-            } else if(tlos_price > 20000) { // If TLOS daily close of $2.00, the payout will be decreased to 1/3
-               payout /= 3;
-            }
-            new_tokens += payout;
-         }
-         else
-         {
-            new_tokens += total_due;
+         uint64_t total_due = (payouts_due * itr->amount) * 10000;
+         if (itr->to == REX_ACCOUNT) {
+            rex_due += total_due;
+         } else {
+            flows.payout.amount += total_due;
          }
+         flows.due.push_back(itr->to);
       }
 
-      // Check if any payouts are needed to be made
-      check(payouts_made, "No payouts are due");
+      // The TLOS price is only needed to scale a due REX payout
+      if (flows.due.empty())
+         return flows;
+
+      if (rex_due > 0) {
+         // Gets daily median TLOS price, without refreshing the cached one for a preview
+         const uint64_t tlos_price = refresh_price ? get_telos_average_price() : peek_telos_average_price();
+
+         // REX payout is decreased to 2/3 from a TLOS daily close of $1.00 and to 1/3 above $2.00
+         uint64_t rex_numerator = 1, rex_denominator = 1;
+         if(tlos_price >= 10000 && tlos_price < 20000) {
+            rex_numerator = 2;
+            rex_denominator = 3;
+         } else if(tlos_price > 20000) {
+            rex_denominator = 3;
+         }
+         flows.payout.amount += rex_due * rex_numerator / rex_denominator;
+      }
 
       // Gets the TEDP account balance
-      asset tedp_balance = eosio::token::get_balance(token_account, tedp_account, core_symbol().code());
+      flows.tedp_balance = eosio::token::get_balance(token_account, tedp_account, core_symbol().code());
 
       // Calculates the amount of TLOS need to be issued
-      int64_t issue_tokens = 0;
-      if (tedp_balance.amount > 0) {
-         if (tedp_balance.amount < new_tokens) {
-            issue_tokens = new_tokens - tedp_balance.amount;
+      if (flows.tedp_balance.amount > 0) {
+         if (flows.tedp_balance.amount < flows.payout.amount) {
+            flows.issue.amount = flows.payout.amount - flows.tedp_balance.amount;
          }
       } else {
-         issue_tokens = new_tokens;
+         flows.issue.amount = flows.payout.amount;
       }
-      
+
+      return flows;
+   }
+
+   void system_contract::pay() {
+      const tedp_pay_flows flows = get_tedp_pay_flows(true);
+
+      // Check if any payouts are needed to be made
+      check(!flows.due.empty(), "No payouts are due");
+
       // Issues TLOS if the TEDP account doesn't have sufficient balance
-      if (issue_tokens > 0) {
+      if (flows.issue.amount > 0) {
          token::transfer_action transfer_act{ token_account, { get_self(), active_permission } };
          token::issue_action issue_action{ token_account, { get_self(), active_permission }};
-         issue_action.send(get_self(), asset(issue_tokens, core_symbol()), "Issue new TLOS tokens");
-         transfer_act.send(get_self(), tedp_account, asset(issue_tokens, core_symbol()), "Transfer issued TLOS to TEDP account");
+         issue_action.send(get_self(), flows.issue, "Issue new TLOS tokens");
+         transfer_act.send(get_self(), tedp_account, flows.issue, "Transfer issued TLOS to TEDP account");
       }
 
       // Triggers pay action of TEDP account to distribute payouts
@@ -473,6 +584,11 @@ namespace eosiosystem {
          std::make_tuple()
       ).send();
    }
+
+   tedp_pay_flows system_contract::paypreview() {
+      // Only reads tables, a cached_singleton would write its row back when the action ends
+      return get_tedp_pay_flows(false);
+   }
    // TELOS END
 
 } //namespace eosiosystem
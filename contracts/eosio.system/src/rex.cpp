@@ -107,13 +107,21 @@ namespace eosiosystem {
       auto bitr = _rexbalance.require_find( from.value, "user must first buyrex" );
       check( rex.amount > 0 && rex.symbol == bitr->rex_balance.symbol,
              "asset must be a positive amount of (REX, 4)" );
-      process_rex_maturities( bitr );
-      check( rex.amount <= bitr->matured_rex, "insufficient available rex" );
+      rex_balance rb = *bitr;
+      process_rex_maturities( rb );
+      check( rex.amount <= rb.matured_rex, "insufficient available rex" );
 
-      const auto current_order = fill_rex_order( bitr, rex );
+      rex_pool pool = *_rexpool.begin();
+      const auto current_order = fill_rex_order( pool, rb, rex );
       if ( current_order.success && current_order.proceeds.amount == 0 ) {
          check( false, "proceeds are negligible" );
       }
+      save_rex_balance( bitr, rb );
+      if ( current_order.success ) {
+         _rexpool.modify( _rexpool.begin(), same_payer, [&]( auto& rt ) {
+            rt = pool;
+         });
+      }
       asset pending_sell_order = update_rex_account( from, current_order.proceeds, current_order.stake_change );
       if ( !current_order.success ) {
          if ( from == "b1"_n ) {
@@ -161,8 +169,7 @@ namespace eosiosystem {
    {
       require_auth( from );
 
-      rex_cpu_loan_table cpu_loans( get_self(), get_self().value );
-      int64_t rented_tokens = rent_rex( cpu_loans, from, receiver, loan_payment, loan_fund );
+      int64_t rented_tokens = rent_rex( rex_loan_resource::cpu, from, receiver, loan_payment, loan_fund );
       update_resource_limits( from, receiver, 0, rented_tokens );
    }
 
@@ -170,8 +177,7 @@ namespace eosiosystem {
    {
       require_auth( from );
 
-      rex_net_loan_table net_loans( get_self(), get_self().value );
-      int64_t rented_tokens = rent_rex( net_loans, from, receiver, loan_payment, loan_fund );
+      int64_t rented_tokens = rent_rex( rex_loan_resource::net, from, receiver, loan_payment, loan_fund );
       update_resource_limits( from, receiver, rented_tokens, 0 );
    }
 
@@ -179,32 +185,36 @@ namespace eosiosystem {
    {
       require_auth( from );
 
-      rex_cpu_loan_table cpu_loans( get_self(), get_self().value );
-      fund_rex_loan( cpu_loans, from, loan_num, payment  );
+      with_rex_loan_table( rex_loan_resource::cpu, loan_num, [&]( auto& loans ) {
+         fund_rex_loan( loans, from, loan_num, payment );
+      });
    }
 
    void system_contract::fundnetloan( const name& from, uint64_t loan_num, const asset& payment )
    {
       require_auth( from );
 
-      rex_net_loan_table net_loans( get_self(), get_self().value );
-      fund_rex_loan( net_loans, from, loan_num, payment );
+      with_rex_loan_table( rex_loan_resource::net, loan_num, [&]( auto& loans ) {
+         fund_rex_loan( loans, from, loan_num, payment );
+      });
    }
 
    void system_contract::defcpuloan( const name& from, uint64_t loan_num, const asset& amount )
    {
       require_auth( from );
 
-      rex_cpu_loan_table cpu_loans( get_self(), get_self().value );
-      defund_rex_loan( cpu_loans, from, loan_num, amount );
+      with_rex_loan_table( rex_loan_resource::cpu, loan_num, [&]( auto& loans ) {
+         defund_rex_loan( loans, from, loan_num, amount );
+      });
    }
 
    void system_contract::defnetloan( const name& from, uint64_t loan_num, const asset& amount )
    {
       require_auth( from );
 
-      rex_net_loan_table net_loans( get_self(), get_self().value );
-      defund_rex_loan( net_loans, from, loan_num, amount );
+      with_rex_loan_table( rex_loan_resource::net, loan_num, [&]( auto& loans ) {
+         defund_rex_loan( loans, from, loan_num, amount );
+      });
    }
 
    void system_contract::updaterex( const name& owner )
@@ -225,12 +235,13 @@ namespace eosiosystem {
       if ( total_rex > 0 ) {
          current_stake.amount = ( uint128_t(rex_balance) * total_lendable ) / total_rex;
       }
-      _rexbalance.modify( itr, same_payer, [&]( auto& rb ) {
-         rb.vote_stake = current_stake;
-      });
+      // maturities do not affect the vote stake, so they are processed in the same write
+      auto rb       = *itr; // the local rex_balance amount shadows the row type here
+      rb.vote_stake = current_stake;
+      process_rex_maturities( rb );
+      save_rex_balance( itr, rb );
 
       update_rex_account( owner, asset( 0, core_symbol() ), current_stake - init_stake, true );
-      process_rex_maturities( itr );
    }
 
    void system_contract::setrex( const asset& balance )
@@ -249,8 +260,36 @@ namespace eosiosystem {
    {
       require_auth( user );
 
-      runrex( max );
+      // TELOS BEGIN
+      if ( !_grexmaint->scheduled ) {
+         runrex( max );
+         return;
+      }
+
+      const auto& maint = *_grexmaint;
+      const auto  done  = process_rex_queues( std::min( max, maint.cpu_loan_budget ),
+                                              std::min( max, maint.net_loan_budget ),
+                                              std::min( max, maint.sell_order_budget ) );
+      if ( done.cpu_loans > 0 || done.net_loans > 0 || done.sell_orders > 0 ) {
+         rex_results::execresult_action execresult_act( rex_account, std::vector<eosio::permission_level>{ } );
+         execresult_act.send( done.cpu_loans, done.net_loans, done.sell_orders );
+      }
+      // TELOS END
+   }
+
+   // TELOS BEGIN
+   void system_contract::setrexmaint( bool scheduled, uint16_t cpu_loan_budget, uint16_t net_loan_budget, uint16_t sell_order_budget )
+   {
+      require_auth( get_self() );
+
+      check( !scheduled || ( cpu_loan_budget > 0 && net_loan_budget > 0 && sell_order_budget > 0 ),
+             "scheduled maintenance budgets must be positive" );
+      _grexmaint->scheduled         = scheduled;
+      _grexmaint->cpu_loan_budget   = cpu_loan_budget;
+      _grexmaint->net_loan_budget   = net_loan_budget;
+      _grexmaint->sell_order_budget = sell_order_budget;
    }
+   // TELOS END
 
    void system_contract::consolidate( const name& owner )
    {
@@ -260,7 +299,9 @@ namespace eosiosystem {
 
       auto bitr = _rexbalance.require_find( owner.value, "account has no REX balance" );
       asset rex_in_sell_order = update_rex_account( owner, asset( 0, core_symbol() ), asset( 0, core_symbol() ) );
-      consolidate_rex_balance( bitr, rex_in_sell_order );
+      rex_balance rb = *bitr;
+      consolidate_rex_balance( rb, rex_in_sell_order );
+      save_rex_balance( bitr, rb );
    }
 
    void system_contract::mvtosavings( const name& owner, const asset& rex )
@@ -272,29 +313,29 @@ namespace eosiosystem {
       auto bitr = _rexbalance.require_find( owner.value, "account has no REX balance" );
       check( rex.amount > 0 && rex.symbol == bitr->rex_balance.symbol, "asset must be a positive amount of (REX, 4)" );
       const asset   rex_in_sell_order = update_rex_account( owner, asset( 0, core_symbol() ), asset( 0, core_symbol() ) );
-      const int64_t rex_in_savings    = read_rex_savings( bitr );
-      check( rex.amount + rex_in_sell_order.amount + rex_in_savings <= bitr->rex_balance.amount,
+      rex_balance   rb                = *bitr;
+      const int64_t rex_in_savings    = read_rex_savings( rb );
+      check( rex.amount + rex_in_sell_order.amount + rex_in_savings <= rb.rex_balance.amount,
              "insufficient REX balance" );
-      process_rex_maturities( bitr );
-      _rexbalance.modify( bitr, same_payer, [&]( auto& rb ) {
-         int64_t moved_rex = 0;
-         while ( !rb.rex_maturities.empty() && moved_rex < rex.amount) {
-            const int64_t d_rex = std::min( rex.amount - moved_rex, rb.rex_maturities.back().second );
-            rb.rex_maturities.back().second -= d_rex;
-            moved_rex                       += d_rex;
-            if ( rb.rex_maturities.back().second == 0 ) {
-               rb.rex_maturities.pop_back();
-            }
-         }
-         if ( moved_rex < rex.amount ) {
-            const int64_t d_rex = rex.amount - moved_rex;
-            rb.matured_rex    -= d_rex;
-            moved_rex         += d_rex;
-            check( rex_in_sell_order.amount <= rb.matured_rex, "logic error in mvtosavings" );
+      process_rex_maturities( rb );
+      int64_t moved_rex = 0;
+      while ( !rb.rex_maturities.empty() && moved_rex < rex.amount) {
+         const int64_t d_rex = std::min( rex.amount - moved_rex, rb.rex_maturities.back().second );
+         rb.rex_maturities.back().second -= d_rex;
+         moved_rex                       += d_rex;
+         if ( rb.rex_maturities.back().second == 0 ) {
+            rb.rex_maturities.pop_back();
          }
-         check( moved_rex == rex.amount, "programmer error in mvtosavings" );
-      });
-      put_rex_savings( bitr, rex_in_savings + rex.amount );
+      }
+      if ( moved_rex < rex.amount ) {
+         const int64_t d_rex = rex.amount - moved_rex;
+         rb.matured_rex    -= d_rex;
+         moved_rex         += d_rex;
+         check( rex_in_sell_order.amount <= rb.matured_rex, "logic error in mvtosavings" );
+      }
+      check( moved_rex == rex.amount, "programmer error in mvtosavings" );
+      put_rex_savings( rb, rex_in_savings + rex.amount );
+      save_rex_balance( bitr, rb );
    }
 
    void system_contract::mvfrsavings( const name& owner, const asset& rex )
@@ -305,18 +346,18 @@ namespace eosiosystem {
 
       auto bitr = _rexbalance.require_find( owner.value, "account has no REX balance" );
       check( rex.amount > 0 && rex.symbol == bitr->rex_balance.symbol, "asset must be a positive amount of (REX, 4)" );
-      const int64_t rex_in_savings = read_rex_savings( bitr );
+      rex_balance   rb             = *bitr;
+      const int64_t rex_in_savings = read_rex_savings( rb );
       check( rex.amount <= rex_in_savings, "insufficient REX in savings" );
-      process_rex_maturities( bitr );
-      _rexbalance.modify( bitr, same_payer, [&]( auto& rb ) {
-         const time_point_sec maturity = get_rex_maturity();
-         if ( !rb.rex_maturities.empty() && rb.rex_maturities.back().first == maturity ) {
-            rb.rex_maturities.back().second += rex.amount;
-         } else {
-            rb.rex_maturities.emplace_back( pair_time_point_sec_int64 { maturity, rex.amount } );
-         }
-      });
-      put_rex_savings( bitr, rex_in_savings - rex.amount );
+      process_rex_maturities( rb );
+      const time_point_sec maturity = get_rex_maturity();
+      if ( !rb.rex_maturities.empty() && rb.rex_maturities.back().first == maturity ) {
+         rb.rex_maturities.back().second += rex.amount;
+      } else {
+         rb.rex_maturities.emplace_back( pair_time_point_sec_int64 { maturity, rex.amount } );
+      }
+      put_rex_savings( rb, rex_in_savings - rex.amount );
+      save_rex_balance( bitr, rb );
       update_rex_account( owner, asset( 0, core_symbol() ), asset( 0, core_symbol() ) );
    }
 
@@ -339,10 +380,16 @@ namespace eosiosystem {
          auto net_idx = net_loans.get_index<"byowner"_n>();
          bool no_outstanding_net_loans = ( net_idx.find( owner.value ) == net_idx.end() );
 
+         // TELOS BEGIN
+         rex_loan_table loans( get_self(), get_self().value );
+         auto loan_idx = loans.get_index<"byowner"_n>();
+         bool no_outstanding_loans = ( loan_idx.find( owner.value ) == loan_idx.end() );
+         // TELOS END
+
          auto fund_itr = _rexfunds.find( owner.value );
          bool no_outstanding_rex_fund = ( fund_itr != _rexfunds.end() ) && ( fund_itr->balance.amount == 0 );
 
-         if ( no_outstanding_cpu_loans && no_outstanding_net_loans && no_outstanding_rex_fund ) {
+         if ( no_outstanding_cpu_loans && no_outstanding_net_loans && no_outstanding_loans && no_outstanding_rex_fund ) {
             _rexfunds.erase( fund_itr );
          }
       }
@@ -476,7 +523,8 @@ namespace eosiosystem {
     *
     * @param loan - loan to be closed
     */
-   void system_contract::remove_loan_from_rex_pool( const rex_loan& loan )
+   template <typename Loan>
+   void system_contract::remove_loan_from_rex_pool( const Loan& loan )
    {
       const auto& pool = _rexpool.begin();
       const int64_t delta_total_rent = exchange_state::get_bancor_output( pool->total_unlent.amount,
@@ -510,9 +558,31 @@ namespace eosiosystem {
    /**
     * @brief Performs maintenance operations on expired NET and CPU loans and sellrex orders
     *
+    * While REX maintenance is scheduled, only REX returns are distributed and the rest is left to rexexec.
+    *
     * @param max - maximum number of each of the three categories to be processed
     */
    void system_contract::runrex( uint16_t max )
+   {
+      // TELOS BEGIN
+      const uint16_t budget = _grexmaint->scheduled ? 0 : max;
+      process_rex_queues( budget, budget, budget );
+      // TELOS END
+   }
+
+   /**
+    * @brief Distributes REX returns, then processes expired CPU and NET loans and open sellrex orders
+    *
+    * A category is skipped without opening its table when its budget is zero, and left as soon as the head of its
+    * queue is not due.
+    *
+    * @param max_cpu_loans - maximum number of expired CPU loans to be processed
+    * @param max_net_loans - maximum number of expired NET loans to be processed
+    * @param max_sell_orders - maximum number of open sellrex orders to be processed
+    *
+    * @return rex_maintenance_result - number of items processed in each category
+    */
+   rex_maintenance_result system_contract::process_rex_queues( uint16_t max_cpu_loans, uint16_t max_net_loans, uint16_t max_sell_orders )
    {
       check( rex_system_initialized(), "rex system not initialized yet" );
 
@@ -520,35 +590,31 @@ namespace eosiosystem {
 
       const auto& pool = _rexpool.begin();
 
-      auto process_expired_loan = [&]( auto& idx, const auto& itr ) -> std::pair<bool, int64_t> {
+      // TELOS BEGIN
+      /// closes an expired loan in rex_pool and renews it there when possible,
+      /// returns whether the loan is renewed and the tokens rented at the current price
+      auto process_expired_loan = [&]( const auto& loan ) -> std::pair<bool, int64_t> {
          /// update rex_pool in order to delete existing loan
-         remove_loan_from_rex_pool( *itr );
-         bool    delete_loan   = false;
-         int64_t delta_stake   = 0;
+         remove_loan_from_rex_pool( loan );
          /// calculate rented tokens at current price
          int64_t rented_tokens = exchange_state::get_bancor_output( pool->total_rent.amount,
                                                                     pool->total_unlent.amount,
-                                                                    itr->payment.amount );
+                                                                    loan.payment.amount );
          /// conditions for loan renewal
-         bool renew_loan = itr->payment <= itr->balance        /// loan has sufficient balance
-                        && itr->payment.amount < rented_tokens /// loan has favorable return
+         bool renew_loan = loan.payment <= loan.balance        /// loan has sufficient balance
+                        && loan.payment.amount < rented_tokens /// loan has favorable return
                         && rex_loans_available();              /// no pending sell orders
          if ( renew_loan ) {
             /// update rex_pool in order to account for renewed loan
-            add_loan_to_rex_pool( itr->payment, rented_tokens, false );
-            /// update renewed loan fields
-            delta_stake = update_renewed_loan( idx, itr, rented_tokens );
-         } else {
-            delete_loan = true;
-            delta_stake = -( itr->total_staked.amount );
+            add_loan_to_rex_pool( loan.payment, rented_tokens, false );
+         } else if ( loan.balance.amount > 0 ) {
             /// refund "from" account if the closed loan balance is positive
-            if ( itr->balance.amount > 0 ) {
-               transfer_to_fund( itr->from, itr->balance );
-            }
+            transfer_to_fund( loan.from, loan.balance );
          }
 
-         return { delete_loan, delta_stake };
+         return { renew_loan, rented_tokens };
       };
+      // TELOS END
 
       /// transfer from eosio.names to eosio.rex
       if ( pool->namebid_proceeds.amount > 0 ) {
@@ -558,67 +624,133 @@ namespace eosiosystem {
          });
       }
 
-      /// process cpu loans
-      {
-         rex_cpu_loan_table cpu_loans( get_self(), get_self().value );
-         auto cpu_idx = cpu_loans.get_index<"byexpr"_n>();
-         for ( uint16_t i = 0; i < max; ++i ) {
-            auto itr = cpu_idx.begin();
-            if ( itr == cpu_idx.end() || itr->expiration > current_time_point() ) break;
+      rex_maintenance_result done;
+      const time_point now = current_time_point();
+
+      // TELOS BEGIN
+      // Stake changes are summed per (from, receiver) and applied once, after all loans of this run are processed
+      struct limit_delta {
+         name    from;
+         name    receiver;
+         int64_t net = 0;
+         int64_t cpu = 0;
+      };
+      std::vector<limit_delta> limit_deltas;
+      auto add_limit_delta = [&]( const name& from, const name& receiver, bool cpu, int64_t delta_stake ) {
+         if ( delta_stake == 0 ) return;
+         auto itr = std::find_if( limit_deltas.begin(), limit_deltas.end(), [&]( const limit_delta& d ) {
+            return d.from == from && d.receiver == receiver;
+         });
+         if ( itr == limit_deltas.end() ) {
+            itr = limit_deltas.insert( limit_deltas.end(), limit_delta{ from, receiver } );
+         }
+         ( cpu ? itr->cpu : itr->net ) += delta_stake;
+      };
+
+      rex_loan_table loans( get_self(), get_self().value );
 
-            auto result = process_expired_loan( cpu_idx, itr );
-            if ( result.second != 0 )
-               update_resource_limits( itr->from, itr->receiver, 0, result.second );
+      /// process cpu and net loans of the legacy tables, renewed ones stay there so that no new row is billed to
+      /// `from` in a transaction it did not sign
+      auto process_legacy_loans = [&]( auto& legacy_loans, bool cpu, uint16_t max, uint16_t& count ) {
+         auto idx = legacy_loans.template get_index<"byexpr"_n>();
+         for ( ; count < max; ++count ) {
+            auto itr = idx.begin();
+            if ( itr == idx.end() || itr->expiration > now ) break;
 
-            if ( result.first )
-               cpu_idx.erase( itr );
+            const auto result = process_expired_loan( *itr );
+            if ( result.first ) {
+               add_limit_delta( itr->from, itr->receiver, cpu, update_renewed_loan( idx, itr, result.second ) );
+            } else {
+               add_limit_delta( itr->from, itr->receiver, cpu, -( itr->total_staked.amount ) );
+               idx.erase( itr );
+            }
          }
+      };
+      if ( max_cpu_loans > 0 ) {
+         rex_cpu_loan_table cpu_loans( get_self(), get_self().value );
+         process_legacy_loans( cpu_loans, true, max_cpu_loans, done.cpu_loans );
       }
-
-      /// process net loans
-      {
+      if ( max_net_loans > 0 ) {
          rex_net_loan_table net_loans( get_self(), get_self().value );
-         auto net_idx = net_loans.get_index<"byexpr"_n>();
-         for ( uint16_t i = 0; i < max; ++i ) {
-            auto itr = net_idx.begin();
-            if ( itr == net_idx.end() || itr->expiration > current_time_point() ) break;
+         process_legacy_loans( net_loans, false, max_net_loans, done.net_loans );
+      }
 
-            auto result = process_expired_loan( net_idx, itr );
-            if ( result.second != 0 )
-               update_resource_limits( itr->from, itr->receiver, result.second, 0 );
+      /// process cpu and net loans in expiration order; loans of a resource whose budget is used up are
+      /// skipped, at most as many as the total budget
+      if ( done.cpu_loans < max_cpu_loans || done.net_loans < max_net_loans ) {
+         auto     idx     = loans.get_index<"byexpr"_n>();
+         auto     itr     = idx.begin();
+         uint32_t skipped = 0;
+         while ( itr != idx.end() && itr->expiration <= now
+                 && ( done.cpu_loans < max_cpu_loans || done.net_loans < max_net_loans ) ) {
+            auto next = itr;
+            ++next;
+            const bool cpu   = itr->is_cpu();
+            uint16_t&  count = cpu ? done.cpu_loans : done.net_loans;
+            if ( count == ( cpu ? max_cpu_loans : max_net_loans ) ) {
+               if ( ++skipped > uint32_t(max_cpu_loans) + max_net_loans ) break;
+               itr = next;
+               continue;
+            }
+            ++count;
 
-            if ( result.first )
-               net_idx.erase( itr );
+            const auto result = process_expired_loan( *itr );
+            if ( result.first ) {
+               add_limit_delta( itr->from, itr->receiver, cpu, update_renewed_loan( idx, itr, result.second ) );
+            } else {
+               add_limit_delta( itr->from, itr->receiver, cpu, -( itr->total_staked.amount ) );
+               idx.erase( itr );
+            }
+            itr = next;
          }
       }
 
+      for ( const auto& d : limit_deltas ) {
+         update_resource_limits( d.from, d.receiver, d.net, d.cpu );
+      }
+      // TELOS END
+
       /// process sellrex orders
-      if ( _rexorders.begin() != _rexorders.end() ) {
+      if ( max_sell_orders > 0 && _rexorders.begin() != _rexorders.end() ) {
+         // TELOS BEGIN
+         // Orders are matched in queue order against a working copy of the pool, which is written once for the batch
+         rex_pool order_pool = *_rexpool.begin();
+         std::vector<rex_results::order_fill> fills;
          auto idx  = _rexorders.get_index<"bytime"_n>();
          auto oitr = idx.begin();
-         for ( uint16_t i = 0; i < max; ++i ) {
-            if ( oitr == idx.end() || !oitr->is_open ) break;
+         for ( ; done.sell_orders < max_sell_orders; ++done.sell_orders ) {
+            if ( oitr == idx.end() || !oitr->is_open || available_unlent( order_pool ) < 0 ) break;
             auto next = oitr;
             ++next;
             auto bitr = _rexbalance.find( oitr->owner.value );
             if ( bitr != _rexbalance.end() ) { // should always be true
-               auto result = fill_rex_order( bitr, oitr->rex_requested );
+               rex_balance rb = *bitr;
+               auto result = fill_rex_order( order_pool, rb, oitr->rex_requested );
                if ( result.success ) {
-                  const name order_owner = oitr->owner;
+                  save_rex_balance( bitr, rb );
+                  fills.push_back( rex_results::order_fill{ oitr->owner, result.proceeds } );
                   idx.modify( oitr, same_payer, [&]( auto& order ) {
                      order.proceeds.amount     = result.proceeds.amount;
                      order.stake_change.amount = result.stake_change.amount;
                      order.close();
                   });
-                  /// send dummy action to show owner and proceeds of filled sellrex order
-                  rex_results::orderresult_action order_act( rex_account, std::vector<eosio::permission_level>{ } );
-                  order_act.send( order_owner, result.proceeds );
                }
             }
             oitr = next;
          }
+
+         if ( !fills.empty() ) {
+            _rexpool.modify( _rexpool.begin(), same_payer, [&]( auto& rt ) {
+               rt = order_pool;
+            });
+            /// send dummy action to show owners and proceeds of filled sellrex orders
+            rex_results::fillresult_action fill_act( rex_account, std::vector<eosio::permission_level>{ } );
+            fill_act.send( fills );
+         }
+         // TELOS END
       }
 
+      return done;
    }
 
    /**
@@ -641,84 +773,98 @@ namespace eosiosystem {
          return;
       }
 
-      const int64_t  current_rate      = ret_pool_elem->current_rate_of_increase;
-      const uint32_t elapsed_intervals = get_elapsed_intervals( effective_time, ret_pool_elem->last_dist_time );
-      int64_t        change_estimate   = current_rate * elapsed_intervals;
-
-      {
-         const bool new_return_bucket = ret_pool_elem->pending_bucket_time <= effective_time;
-         int64_t        new_bucket_rate = 0;
-         time_point_sec new_bucket_time = time_point_sec::min();
-         _rexretpool.modify( ret_pool_elem, same_payer, [&]( auto& rp ) {
-            if ( new_return_bucket ) {
-               int64_t remainder = rp.pending_bucket_proceeds % rex_return_pool::total_intervals;
-               new_bucket_rate   = ( rp.pending_bucket_proceeds - remainder ) / rex_return_pool::total_intervals;
-               new_bucket_time   = rp.pending_bucket_time;
-               rp.current_rate_of_increase += new_bucket_rate;
-               change_estimate             += remainder + new_bucket_rate * get_elapsed_intervals( effective_time, rp.pending_bucket_time );
-               rp.pending_bucket_proceeds   = 0;
-               rp.pending_bucket_time       = time_point_sec::maximum();
-               if ( new_bucket_time < rp.oldest_bucket_time ) {
-                  rp.oldest_bucket_time = new_bucket_time;
-               }
-            }
-            rp.proceeds      -= change_estimate;
-            rp.last_dist_time = effective_time;
-         });
-
-         if ( new_return_bucket ) {
-            _rexretbuckets.modify( ret_buckets_elem, same_payer, [&]( auto& rb ) {
-               auto iter = std::lower_bound(rb.return_buckets.begin(), rb.return_buckets.end(), new_bucket_time, [](const pair_time_point_sec_int64& bucket, time_point_sec first) {
-                  return bucket.first < first;
-               });
-               if ((iter != rb.return_buckets.end()) && (iter->first == new_bucket_time)) {
-                  iter->second = new_bucket_rate;
-               } else {
-                  rb.return_buckets.insert(iter, pair_time_point_sec_int64{new_bucket_time, new_bucket_rate});
-               }
-            });
-         }
+      // TELOS BEGIN
+      // Pool and buckets are updated in memory and written back once each
+      rex_return_pool rp                = *ret_pool_elem;
+      const int64_t   current_rate      = rp.current_rate_of_increase;
+      const uint32_t  elapsed_intervals = get_elapsed_intervals( effective_time, rp.last_dist_time );
+      int64_t         change_estimate   = current_rate * elapsed_intervals;
+
+      const bool     new_return_bucket = rp.pending_bucket_time <= effective_time;
+      int64_t        new_bucket_rate   = 0;
+      time_point_sec new_bucket_time   = time_point_sec::min();
+      if ( new_return_bucket ) {
+         int64_t remainder = rp.pending_bucket_proceeds % rex_return_pool::total_intervals;
+         new_bucket_rate   = ( rp.pending_bucket_proceeds - remainder ) / rex_return_pool::total_intervals;
+         new_bucket_time   = rp.pending_bucket_time;
+         rp.current_rate_of_increase += new_bucket_rate;
+         change_estimate             += remainder + new_bucket_rate * get_elapsed_intervals( effective_time, rp.pending_bucket_time );
+         rp.pending_bucket_proceeds   = 0;
+         rp.pending_bucket_time       = time_point_sec::maximum();
       }
+      rp.proceeds      -= change_estimate;
+      rp.last_dist_time = effective_time;
 
+      // `oldest_bucket_time` is the time of the oldest bucket, or zero when there is none
       const time_point_sec time_threshold = effective_time - seconds(rex_return_pool::total_intervals * rex_return_pool::dist_interval);
-      if ( ret_pool_elem->oldest_bucket_time <= time_threshold ) {
+      const bool expired_buckets = rp.oldest_bucket_time != time_point_sec::min() && rp.oldest_bucket_time <= time_threshold;
+      if ( new_return_bucket || expired_buckets ) {
+         rex_return_buckets rb = *ret_buckets_elem;
+         rb.to_ring();
+
          int64_t expired_rate = 0;
          int64_t surplus      = 0;
-         _rexretbuckets.modify( ret_buckets_elem, same_payer, [&]( auto& rb ) {
-            auto& return_buckets = rb.return_buckets;
-            auto iter = return_buckets.begin();
-            for (; iter != return_buckets.end() && iter->first <= time_threshold; ++iter) {
-               const uint32_t overtime = get_elapsed_intervals( effective_time,
-                                                                iter->first + seconds(rex_return_pool::total_intervals * rex_return_pool::dist_interval) );
-               surplus      += iter->second * overtime;
-               expired_rate += iter->second;
+         auto expire = [&]( const pair_time_point_sec_int64& bucket ) {
+            const uint32_t overtime = get_elapsed_intervals( effective_time,
+                                                             bucket.first + seconds(rex_return_pool::total_intervals * rex_return_pool::dist_interval) );
+            surplus      += bucket.second * overtime;
+            expired_rate += bucket.second;
+         };
+
+         if ( expired_buckets ) {
+            // existing buckets span at most one window from the oldest one, so this visits each slot at most once
+            time_point_sec bucket_time = rp.oldest_bucket_time;
+            rp.oldest_bucket_time = time_point_sec::min();
+            for ( uint32_t i = 0; i < rex_return_buckets::total_buckets; ++i, bucket_time += rex_return_buckets::bucket_interval ) {
+               auto& bucket = rb.return_buckets[ rex_return_buckets::slot( bucket_time ) ];
+               if ( bucket.first != bucket_time ) {
+                  continue;
+               }
+               if ( time_threshold < bucket_time ) {
+                  rp.oldest_bucket_time = bucket_time;
+                  break;
+               }
+               expire( bucket );
+               bucket = pair_time_point_sec_int64{};
             }
-            return_buckets.erase(return_buckets.begin(), iter);
-         });
+         }
 
-         _rexretpool.modify( ret_pool_elem, same_payer, [&]( auto& rp ) {
-            if ( !ret_buckets_elem->return_buckets.empty() ) {
-               rp.oldest_bucket_time = ret_buckets_elem->return_buckets.begin()->first;
+         if ( new_return_bucket ) {
+            // the new bucket is newer than any other, its slot is either empty or already holds it
+            const pair_time_point_sec_int64 new_bucket{ new_bucket_time, new_bucket_rate };
+            if ( new_bucket_time <= time_threshold ) {
+               expire( new_bucket );
             } else {
-               rp.oldest_bucket_time = time_point_sec::min();
-            }
-            if ( expired_rate > 0) {
-               rp.current_rate_of_increase -= expired_rate;
-            }
-            if ( surplus > 0 ) {
-               change_estimate -= surplus;
-               rp.proceeds     += surplus;
+               rb.return_buckets[ rex_return_buckets::slot( new_bucket_time ) ] = new_bucket;
+               if ( rp.oldest_bucket_time == time_point_sec::min() ) {
+                  rp.oldest_bucket_time = new_bucket_time;
+               }
             }
+         }
+
+         if ( expired_rate > 0) {
+            rp.current_rate_of_increase -= expired_rate;
+         }
+         if ( surplus > 0 ) {
+            change_estimate -= surplus;
+            rp.proceeds     += surplus;
+         }
+
+         _rexretbuckets.modify( ret_buckets_elem, same_payer, [&]( auto& b ) {
+            b = rb;
          });
       }
 
-      if ( change_estimate > 0 && ret_pool_elem->proceeds < 0 ) {
-         _rexretpool.modify( ret_pool_elem, same_payer, [&]( auto& rp ) {
-            change_estimate += rp.proceeds;
-            rp.proceeds      = 0;
-         });
+      if ( change_estimate > 0 && rp.proceeds < 0 ) {
+         change_estimate += rp.proceeds;
+         rp.proceeds      = 0;
       }
 
+      _rexretpool.modify( ret_pool_elem, same_payer, [&]( auto& p ) {
+         p = rp;
+      });
+      // TELOS END
+
       if ( change_estimate > 0 ) {
          _rexpool.modify( _rexpool.begin(), same_payer, [&]( auto& pool ) {
             pool.total_unlent.amount += change_estimate;
@@ -727,8 +873,7 @@ namespace eosiosystem {
       }
    }
 
-   template <typename T>
-   int64_t system_contract::rent_rex( T& table, const name& from, const name& receiver, const asset& payment, const asset& fund )
+   int64_t system_contract::rent_rex( rex_loan_resource resource, const name& from, const name& receiver, const asset& payment, const asset& fund )
    {
       runrex(2);
 
@@ -746,7 +891,8 @@ namespace eosiosystem {
       check( payment.amount < rented_tokens, "loan price does not favor renting" );
       add_loan_to_rex_pool( payment, rented_tokens, true );
 
-      table.emplace( from, [&]( auto& c ) {
+      rex_loan_table loans( get_self(), get_self().value );
+      loans.emplace( from, [&]( auto& c ) {
          c.from         = from;
          c.receiver     = receiver;
          c.payment      = payment;
@@ -754,6 +900,7 @@ namespace eosiosystem {
          c.total_staked = asset( rented_tokens, core_symbol() );
          c.expiration   = current_time_point() + eosio::days(30);
          c.loan_num     = pool->loan_num;
+         c.resource     = static_cast<uint8_t>( resource );
       });
 
       rex_results::rentresult_action rentresult_act{ rex_account, std::vector<eosio::permission_level>{ } };
@@ -771,17 +918,19 @@ namespace eosiosystem {
     * different function to complete order processing, i.e. transfer proceeds to user REX fund and
     * update user vote weight.
     *
-    * @param bitr - iterator pointing to rex_balance database record
+    * REX pool totals and the owner balance are updated in memory only and the caller writes them back.
+    *
+    * @param pool - working copy of the rex_pool record
+    * @param rb - working copy of owner rex_balance record
     * @param rex - amount of rex to be sold
     *
     * @return rex_order_outcome - a struct containing success flag, order proceeds, and resultant
     * vote stake change
     */
-   rex_order_outcome system_contract::fill_rex_order( const rex_balance_table::const_iterator& bitr, const asset& rex )
+   rex_order_outcome system_contract::fill_rex_order( rex_pool& pool, rex_balance& rb, const asset& rex )
    {
-      auto rexpool_itr = _rexpool.begin();
-      const int64_t S0 = rexpool_itr->total_lendable.amount;
-      const int64_t R0 = rexpool_itr->total_rex.amount;
+      const int64_t S0 = pool.total_lendable.amount;
+      const int64_t R0 = pool.total_rex.amount;
       const int64_t p  = (uint128_t(rex.amount) * S0) / R0;
       const int64_t R1 = R0 - rex.amount;
       const int64_t S1 = S0 - p;
@@ -789,22 +938,16 @@ namespace eosiosystem {
       asset stake_change( 0, core_symbol() );
       bool  success = false;
 
-      const int64_t unlent_lower_bound = rexpool_itr->total_lent.amount / 10;
-      const int64_t available_unlent   = rexpool_itr->total_unlent.amount - unlent_lower_bound; // available_unlent <= 0 is possible
-      if ( proceeds.amount <= available_unlent ) {
-         const int64_t init_vote_stake_amount = bitr->vote_stake.amount;
-         const int64_t current_stake_value    = ( uint128_t(bitr->rex_balance.amount) * S0 ) / R0;
-         _rexpool.modify( rexpool_itr, same_payer, [&]( auto& rt ) {
-            rt.total_rex.amount      = R1;
-            rt.total_lendable.amount = S1;
-            rt.total_unlent.amount   = rt.total_lendable.amount - rt.total_lent.amount;
-         });
-         _rexbalance.modify( bitr, same_payer, [&]( auto& rb ) {
-            rb.vote_stake.amount   = current_stake_value - proceeds.amount;
-            rb.rex_balance.amount -= rex.amount;
-            rb.matured_rex        -= rex.amount;
-         });
-         stake_change.amount = bitr->vote_stake.amount - init_vote_stake_amount;
+      if ( proceeds.amount <= available_unlent( pool ) ) {
+         const int64_t init_vote_stake_amount = rb.vote_stake.amount;
+         const int64_t current_stake_value    = ( uint128_t(rb.rex_balance.amount) * S0 ) / R0;
+         pool.total_rex.amount      = R1;
+         pool.total_lendable.amount = S1;
+         pool.total_unlent.amount   = pool.total_lendable.amount - pool.total_lent.amount;
+         rb.vote_stake.amount   = current_stake_value - proceeds.amount;
+         rb.rex_balance.amount -= rex.amount;
+         rb.matured_rex        -= rex.amount;
+         stake_change.amount = rb.vote_stake.amount - init_vote_stake_amount;
          success = true;
       } else {
          proceeds.amount = 0;
@@ -813,6 +956,40 @@ namespace eosiosystem {
       return { success, proceeds, stake_change };
    }
 
+   // TELOS BEGIN
+   /**
+    * @brief Calls `f` with the table holding loan `loan_num` of `resource`
+    *
+    * Loans created before the unified loan table stay in the CPU or NET loan table until they expire.
+    *
+    * @param resource - resource of the loan
+    * @param loan_num - loan number
+    * @param f - called with the legacy table if it holds the loan, with the loan table otherwise
+    */
+   template <typename F>
+   void system_contract::with_rex_loan_table( rex_loan_resource resource, uint64_t loan_num, F&& f )
+   {
+      if ( resource == rex_loan_resource::cpu ) {
+         rex_cpu_loan_table cpu_loans( get_self(), get_self().value );
+         if ( cpu_loans.find( loan_num ) != cpu_loans.end() ) {
+            f( cpu_loans );
+            return;
+         }
+      } else {
+         rex_net_loan_table net_loans( get_self(), get_self().value );
+         if ( net_loans.find( loan_num ) != net_loans.end() ) {
+            f( net_loans );
+            return;
+         }
+      }
+
+      rex_loan_table loans( get_self(), get_self().value );
+      auto itr = loans.find( loan_num );
+      check( itr == loans.end() || itr->resource == static_cast<uint8_t>( resource ), "loan not found" );
+      f( loans );
+   }
+   // TELOS END
+
    template <typename T>
    void system_contract::fund_rex_loan( T& table, const name& from, uint64_t loan_num, const asset& payment  )
    {
@@ -975,41 +1152,51 @@ namespace eosiosystem {
    /**
     * @brief Updates REX owner maturity buckets
     *
-    * @param bitr - iterator pointing to rex_balance object
+    * @param rb - working copy of rex_balance object
     */
-   void system_contract::process_rex_maturities( const rex_balance_table::const_iterator& bitr )
+   void system_contract::process_rex_maturities( rex_balance& rb )
    {
       const time_point_sec now = current_time_point();
-      _rexbalance.modify( bitr, same_payer, [&]( auto& rb ) {
-         while ( !rb.rex_maturities.empty() && rb.rex_maturities.front().first <= now ) {
-            rb.matured_rex += rb.rex_maturities.front().second;
-            rb.rex_maturities.erase(rb.rex_maturities.begin());
-         }
+      auto first_pending = rb.rex_maturities.begin();
+      while ( first_pending != rb.rex_maturities.end() && first_pending->first <= now ) {
+         rb.matured_rex += first_pending->second;
+         ++first_pending;
+      }
+      rb.rex_maturities.erase( rb.rex_maturities.begin(), first_pending );
+   }
+
+   /**
+    * @brief Writes a working copy of a rex_balance object back to the table in a single update
+    *
+    * @param bitr - iterator pointing to rex_balance object
+    * @param rb - working copy of rex_balance object
+    */
+   void system_contract::save_rex_balance( const rex_balance_table::const_iterator& bitr, const rex_balance& rb )
+   {
+      _rexbalance.modify( bitr, same_payer, [&]( auto& r ) {
+         r = rb;
       });
    }
 
    /**
     * @brief Consolidates REX maturity buckets into one
     *
-    * @param bitr - iterator pointing to rex_balance object
+    * @param rb - working copy of rex_balance object
     * @param rex_in_sell_order - REX tokens in owner unfilled sell order, if one exists
     */
-   void system_contract::consolidate_rex_balance( const rex_balance_table::const_iterator& bitr,
-                                                  const asset& rex_in_sell_order )
+   void system_contract::consolidate_rex_balance( rex_balance& rb, const asset& rex_in_sell_order )
    {
-      const int64_t rex_in_savings = read_rex_savings( bitr );
-      _rexbalance.modify( bitr, same_payer, [&]( auto& rb ) {
-         int64_t total  = rb.matured_rex - rex_in_sell_order.amount;
-         rb.matured_rex = rex_in_sell_order.amount;
-         while ( !rb.rex_maturities.empty() ) {
-            total += rb.rex_maturities.front().second;
-            rb.rex_maturities.erase(rb.rex_maturities.begin());
-         }
-         if ( total > 0 ) {
-            rb.rex_maturities.emplace_back( pair_time_point_sec_int64{ get_rex_maturity(), total } );
-         }
-      });
-      put_rex_savings( bitr, rex_in_savings );
+      const int64_t rex_in_savings = read_rex_savings( rb );
+      int64_t total  = rb.matured_rex - rex_in_sell_order.amount;
+      rb.matured_rex = rex_in_sell_order.amount;
+      for ( const auto& maturity : rb.rex_maturities ) {
+         total += maturity.second;
+      }
+      rb.rex_maturities.clear();
+      if ( total > 0 ) {
+         rb.rex_maturities.emplace_back( pair_time_point_sec_int64{ get_rex_maturity(), total } );
+      }
+      put_rex_savings( rb, rex_in_savings );
    }
 
    /**
@@ -1086,7 +1273,7 @@ namespace eosiosystem {
 
       const time_point_sec ct              = current_time_point();
       const uint32_t       cts             = ct.sec_since_epoch();
-      const uint32_t       bucket_interval = rex_return_pool::hours_per_bucket * seconds_per_hour;
+      const uint32_t       bucket_interval = rex_return_buckets::bucket_interval;
       const time_point_sec effective_time{cts - cts % bucket_interval + bucket_interval};
       const auto return_pool_elem = _rexretpool.begin();
       if ( return_pool_elem == _rexretpool.end() ) {
@@ -1096,7 +1283,9 @@ namespace eosiosystem {
             rp.pending_bucket_time     = effective_time;
             rp.proceeds                = fee.amount;
          });
-         _rexretbuckets.emplace( get_self(), [&]( auto& rb ) { } );
+         _rexretbuckets.emplace( get_self(), [&]( auto& rb ) {
+            rb.to_ring();
+         });
       } else {
          _rexretpool.modify( return_pool_elem, same_payer, [&]( auto& rp ) {
             rp.pending_bucket_proceeds += fee.amount;
@@ -1122,34 +1311,39 @@ namespace eosiosystem {
       asset init_rex_stake( 0, core_symbol() );
       asset current_rex_stake( 0, core_symbol() );
       auto bitr = _rexbalance.find( owner.value );
-      if ( bitr == _rexbalance.end() ) {
-         bitr = _rexbalance.emplace( owner, [&]( auto& rb ) {
-            rb.owner       = owner;
-            rb.vote_stake  = payment;
-            rb.rex_balance = rex_received;
-         });
+      const bool new_balance = bitr == _rexbalance.end();
+      rex_balance rb;
+      if ( new_balance ) {
+         rb.owner       = owner;
+         rb.vote_stake  = payment;
+         rb.rex_balance = rex_received;
          current_rex_stake.amount = payment.amount;
       } else {
-         init_rex_stake.amount = bitr->vote_stake.amount;
-         _rexbalance.modify( bitr, same_payer, [&]( auto& rb ) {
-            rb.rex_balance.amount += rex_received.amount;
-            rb.vote_stake.amount   = ( uint128_t(rb.rex_balance.amount) * _rexpool.begin()->total_lendable.amount )
-                                     / _rexpool.begin()->total_rex.amount;
-         });
-         current_rex_stake.amount = bitr->vote_stake.amount;
+         rb = *bitr;
+         init_rex_stake.amount  = rb.vote_stake.amount;
+         rb.rex_balance.amount += rex_received.amount;
+         rb.vote_stake.amount   = ( uint128_t(rb.rex_balance.amount) * _rexpool.begin()->total_lendable.amount )
+                                  / _rexpool.begin()->total_rex.amount;
+         current_rex_stake.amount = rb.vote_stake.amount;
       }
 
-      const int64_t rex_in_savings = read_rex_savings( bitr );
-      process_rex_maturities( bitr );
-      _rexbalance.modify( bitr, same_payer, [&]( auto& rb ) {
-         const time_point_sec maturity = get_rex_maturity();
-         if ( !rb.rex_maturities.empty() && rb.rex_maturities.back().first == maturity ) {
-            rb.rex_maturities.back().second += rex_received.amount;
-         } else {
-            rb.rex_maturities.emplace_back( pair_time_point_sec_int64 { maturity, rex_received.amount } );
-         }
-      });
-      put_rex_savings( bitr, rex_in_savings );
+      const int64_t rex_in_savings = read_rex_savings( rb );
+      process_rex_maturities( rb );
+      const time_point_sec maturity = get_rex_maturity();
+      if ( !rb.rex_maturities.empty() && rb.rex_maturities.back().first == maturity ) {
+         rb.rex_maturities.back().second += rex_received.amount;
+      } else {
+         rb.rex_maturities.emplace_back( pair_time_point_sec_int64 { maturity, rex_received.amount } );
+      }
+      put_rex_savings( rb, rex_in_savings );
+
+      if ( new_balance ) {
+         _rexbalance.emplace( owner, [&]( auto& r ) {
+            r = rb;
+         });
+      } else {
+         save_rex_balance( bitr, rb );
+      }
       return current_rex_stake - init_rex_stake;
    }
 
@@ -1160,19 +1354,17 @@ namespace eosiosystem {
     * allow uniform processing of remaining buckets as savings is a special case. This
     * function is used in conjunction with put_rex_savings.
     *
-    * @param bitr - iterator pointing to rex_balance object
+    * @param rb - working copy of rex_balance object
     *
     * @return int64_t - amount of REX in savings bucket
     */
-   int64_t system_contract::read_rex_savings( const rex_balance_table::const_iterator& bitr )
+   int64_t system_contract::read_rex_savings( rex_balance& rb )
    {
       int64_t rex_in_savings = 0;
       static const time_point_sec end_of_days = time_point_sec::maximum();
-      if ( !bitr->rex_maturities.empty() && bitr->rex_maturities.back().first == end_of_days ) {
-         _rexbalance.modify( bitr, same_payer, [&]( auto& rb ) {
-            rex_in_savings = rb.rex_maturities.back().second;
-            rb.rex_maturities.pop_back();
-         });
+      if ( !rb.rex_maturities.empty() && rb.rex_maturities.back().first == end_of_days ) {
+         rex_in_savings = rb.rex_maturities.back().second;
+         rb.rex_maturities.pop_back();
       }
       return rex_in_savings;
    }
@@ -1180,20 +1372,18 @@ namespace eosiosystem {
    /**
     * @brief Adds a specified REX amount to savings bucket
     *
-    * @param bitr - iterator pointing to rex_balance object
+    * @param rb - working copy of rex_balance object
     * @param rex - amount of REX to be added
     */
-   void system_contract::put_rex_savings( const rex_balance_table::const_iterator& bitr, int64_t rex )
+   void system_contract::put_rex_savings( rex_balance& rb, int64_t rex )
    {
       if ( rex == 0 ) return;
       static const time_point_sec end_of_days = time_point_sec::maximum();
-      _rexbalance.modify( bitr, same_payer, [&]( auto& rb ) {
-         if ( !rb.rex_maturities.empty() && rb.rex_maturities.back().first == end_of_days ) {
-            rb.rex_maturities.back().second += rex;
-         } else {
-            rb.rex_maturities.emplace_back( pair_time_point_sec_int64{ end_of_days, rex } );
-         }
-      });
+      if ( !rb.rex_maturities.empty() && rb.rex_maturities.back().first == end_of_days ) {
+         rb.rex_maturities.back().second += rex;
+      } else {
+         rb.rex_maturities.emplace_back( pair_time_point_sec_int64{ end_of_days, rex } );
+      }
    }
 
    /**
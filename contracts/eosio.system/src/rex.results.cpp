@@ -6,6 +6,10 @@ void rex_results::sellresult( const asset& proceeds ) { }
 
 void rex_results::orderresult( const name& owner, const asset& proceeds ) { }
 
+void rex_results::fillresult( const std::vector<order_fill>& fills ) { }
+
 void rex_results::rentresult( const asset& rented_tokens ) { }
 
+void rex_results::execresult( uint16_t cpu_loans, uint16_t net_loans, uint16_t sell_orders ) { }
+
 extern "C" void apply( uint64_t, uint64_t, uint64_t ) { }
@@ -1,21 +1,19 @@
 #include <eosio.system/eosio.system.hpp>
 #include <eosio/producer_schedule.hpp>
 
-#define MAX_BLOCK_PER_CYCLE 12
-
 namespace eosiosystem {
   using namespace eosio;
 
   bool system_contract::crossed_missed_blocks_threshold(uint32_t amountBlocksMissed, uint32_t schedule_size) {
     if (schedule_size <= 1) return false;
 
-    auto timeframe = (_grotation.next_rotation_time.to_time_point() - _grotation.last_rotation_time.to_time_point()).to_seconds();
+    auto timeframe = (_grotation->next_rotation_time.to_time_point() - _grotation->last_rotation_time.to_time_point()).to_seconds();
     // Total blocks that can be produced in a cycle
-    auto maxBlocksPerCycle = (schedule_size - 1) * MAX_BLOCK_PER_CYCLE;
+    auto maxBlocksPerCycle = (schedule_size - 1) * active_schedule_policy::max_blocks_per_cycle;
     // total block that can be produced in the current timeframe
     auto totalBlocksPerTimeframe = (maxBlocksPerCycle * timeframe) / (maxBlocksPerCycle / 2);
     // max blocks that can be produced by a single producer in a timeframe
-    auto maxBlocksPerProducer = (totalBlocksPerTimeframe * MAX_BLOCK_PER_CYCLE) / maxBlocksPerCycle;
+    auto maxBlocksPerProducer = (totalBlocksPerTimeframe * active_schedule_policy::max_blocks_per_cycle) / maxBlocksPerCycle;
     // 15% is the max allowed missed blocks per single producer
     auto thresholdMissedBlocks = maxBlocksPerProducer * 0.15;
 
@@ -23,87 +21,74 @@ namespace eosiosystem {
   }
 
   void system_contract::reset_schedule_metrics(name producer = name(0)) {
-    for (auto &pm : _gschedule_metrics.producers_metric) {
-      if (producer != name(0) && pm.bp_name == producer) pm.missed_blocks_per_cycle = MAX_BLOCK_PER_CYCLE - 1;
-      else pm.missed_blocks_per_cycle = MAX_BLOCK_PER_CYCLE;
+    for (auto &pm : _gschedule_metrics->producers_metric) {
+      pm.missed_blocks_per_cycle = active_schedule_policy::max_blocks_per_cycle;
+    }
+    if (producer != name(0)) {
+      if (auto pm = _gschedule_metrics->find_metric(producer)) pm->missed_blocks_per_cycle = active_schedule_policy::max_blocks_per_cycle - 1;
     }
   }
 
   void system_contract::update_producer_missed_blocks(name producer) {
-    for (auto &pm : _gschedule_metrics.producers_metric) {
-      if (pm.bp_name == producer && pm.missed_blocks_per_cycle > 0) {
-        pm.missed_blocks_per_cycle--;
-        break;
-      }
+    auto pm = _gschedule_metrics->find_metric(producer);
+    if (pm && pm->missed_blocks_per_cycle > 0) {
+      pm->missed_blocks_per_cycle--;
     }
   }
 
-  bool system_contract::is_new_schedule_activated(name active_schedule[], uint32_t size) {
-    std::vector<name> new_schedule;
-    for (auto &p : _gschedule_metrics.producers_metric) new_schedule.emplace_back(p.bp_name);
+  bool system_contract::is_new_schedule_activated(const std::vector<name>& active_schedule) {
+    const auto& metrics = _gschedule_metrics->producers_metric;
+    if (active_schedule.size() != metrics.size()) return false;
 
-    std::sort(new_schedule.begin(), new_schedule.end());
-    std::sort(active_schedule, active_schedule + size);
-
-    for (size_t i = 0; i < size; i++){
-      if (active_schedule[i] != new_schedule[i]) return false;
+    uint64_t proposed_fingerprint = 0;
+    if (_gschedule_metrics->schedule_fingerprint.has_value()) {
+      proposed_fingerprint = _gschedule_metrics->schedule_fingerprint.value();
+    } else {
+      // metrics written before the fingerprint was tracked
+      for (const auto &pm : metrics) proposed_fingerprint += producer_fingerprint(pm.bp_name);
     }
 
-    return true;
-  }
-
-  bool system_contract::is_new_schedule_activated(std::vector<name>& active_schedule) {
-    std::vector<name> new_schedule;
-    for (auto &p : _gschedule_metrics.producers_metric) new_schedule.emplace_back(p.bp_name);
-
-    std::sort(new_schedule.begin(), new_schedule.end());
-    std::sort(active_schedule.begin(), active_schedule.end());
+    uint64_t active_fingerprint = 0;
+    for (const auto &p : active_schedule) active_fingerprint += producer_fingerprint(p);
 
-    for (size_t i = 0; i < active_schedule.size(); i++) {
-      if (active_schedule[i] != new_schedule[i]) return false;
-    }
-
-    return true;
+    return proposed_fingerprint == active_fingerprint;
   }
 
   bool system_contract::check_missed_blocks(block_timestamp timestamp, name producer) {
     if (producer == "eosio"_n) {
-      _gschedule_metrics.block_counter_correction++;
-      _gschedule_metrics.last_onblock_caller = producer;
+      _gschedule_metrics->block_counter_correction++;
+      _gschedule_metrics->last_onblock_caller = producer;
       return false;
     }
 
     auto producers_schedule = get_active_producers();
-    bool is_activated = _gstate.last_producer_schedule_size == producers_schedule.size() && is_new_schedule_activated(producers_schedule);
+    bool is_activated = _gstate->last_producer_schedule_size == producers_schedule.size() && is_new_schedule_activated(producers_schedule);
 
     if (!is_activated) {
-      if (_gschedule_metrics.last_onblock_caller != producer) _gschedule_metrics.block_counter_correction = 1;
-      else _gschedule_metrics.block_counter_correction++;
+      if (_gschedule_metrics->last_onblock_caller != producer) _gschedule_metrics->block_counter_correction = 1;
+      else _gschedule_metrics->block_counter_correction++;
 
-      _gschedule_metrics.last_onblock_caller = producer;
+      _gschedule_metrics->last_onblock_caller = producer;
       return false;
-    } else if (_gschedule_metrics.block_counter_correction > 0) {
-      if (_gschedule_metrics.last_onblock_caller == "eosio"_n) {
-        for (auto &pm : _gschedule_metrics.producers_metric) {
-          if (pm.bp_name == producer) {
-            pm.missed_blocks_per_cycle -= uint32_t(_gschedule_metrics.block_counter_correction);
-            break;
-          }
+    } else if (_gschedule_metrics->block_counter_correction > 0) {
+      if (_gschedule_metrics->last_onblock_caller == "eosio"_n) {
+        if (auto pm = _gschedule_metrics->find_metric(producer)) {
+          pm->missed_blocks_per_cycle -= uint32_t(_gschedule_metrics->block_counter_correction);
         }
       } else {
           reset_schedule_metrics();
-          _gschedule_metrics.block_counter_correction = -3;
+          _gschedule_metrics->block_counter_correction = -3;
       }
-      _gschedule_metrics.last_onblock_caller = producer;
+      _gschedule_metrics->last_onblock_caller = producer;
     }
 
-    if (_gschedule_metrics.block_counter_correction < 0) {
-      if (_gschedule_metrics.last_onblock_caller != producer && _gschedule_metrics.block_counter_correction < 0) {
-        _gschedule_metrics.block_counter_correction++;
+    if (_gschedule_metrics->block_counter_correction < 0) {
+      if (_gschedule_metrics->last_onblock_caller != producer && _gschedule_metrics->block_counter_correction < 0) {
+        _gschedule_metrics->block_counter_correction++;
       }
 
-      _gschedule_metrics.last_onblock_caller = producer;
-      if (_gschedule_metrics.block_counter_correction < 0) {
+      _gschedule_metrics->last_onblock_caller = producer;
+      if (_gschedule_metrics->block_counter_correction < 0) {
         return false;
       }
     }
@@ -115,20 +100,16 @@ namespace eosiosystem {
       return false;
     }
 
-    if (_gschedule_metrics.last_onblock_caller != producer) {
-      for (auto &pm : _gschedule_metrics.producers_metric) {
-        if (pm.bp_name == producer) {                       
-          if (pm.missed_blocks_per_cycle != MAX_BLOCK_PER_CYCLE) {        
-            _gschedule_metrics.last_onblock_caller = producer;
-            return true;
-          }
-          break;
-        }
+    if (_gschedule_metrics->last_onblock_caller != producer) {
+      auto pm = _gschedule_metrics->find_metric(producer);
+      if (pm && pm->missed_blocks_per_cycle != active_schedule_policy::max_blocks_per_cycle) {
+        _gschedule_metrics->last_onblock_caller = producer;
+        return true;
       }
     }
     
     update_producer_missed_blocks(producer);
-    _gschedule_metrics.last_onblock_caller = producer;
+    _gschedule_metrics->last_onblock_caller = producer;
 
     return false;
   }
@@ -1,37 +1,35 @@
 #include <eosio.system/eosio.system.hpp>
 
-#define TWELVE_HOURS_US 43200000000
-#define SIX_HOURS_US 21600000000
-#define ONE_HOUR_US 900000000       // debug version
-#define SIX_MINUTES_US 360000000    // debug version
-#define TWELVE_MINUTES_US 720000000 // debug version
-#define MAX_PRODUCERS 42     // revised for TEDP 2 Phase 2, also set in producer_pay.cpp, change in both places
-#define TOP_PRODUCERS 21
-#define MAX_VOTE_PRODUCERS 30
-
 namespace eosiosystem {
 using namespace eosio;
 
 void system_contract::set_bps_rotation(name bpOut, name sbpIn) {
-  _grotation.bp_currently_out = bpOut;
-  _grotation.sbp_currently_in = sbpIn;
+  _grotation->bp_currently_out = bpOut;
+  _grotation->sbp_currently_in = sbpIn;
 }
 
 void system_contract::update_rotation_time(block_timestamp block_time) {
-  _grotation.last_rotation_time = block_time;
-  _grotation.next_rotation_time = block_timestamp(
-      block_time.to_time_point() + time_point(microseconds(TWELVE_HOURS_US)));
+  _grotation->last_rotation_time = block_time;
+  _grotation->next_rotation_time = block_timestamp(
+      block_time.to_time_point() + time_point(microseconds(active_schedule_policy::rotation_interval_us)));
 }
 
 void system_contract::update_missed_blocks_per_rotation() {
   auto active_schedule_size =
-      std::distance(_gschedule_metrics.producers_metric.begin(),
-                    _gschedule_metrics.producers_metric.end());
+      std::distance(_gschedule_metrics->producers_metric.begin(),
+                    _gschedule_metrics->producers_metric.end());
   uint16_t max_kick_bps = uint16_t(active_schedule_size / 7);
 
-  std::vector<producer_info> prods;
+  // only the sort keys and the row iterator are kept, not copies of the rows
+  struct missed_blocks_key {
+    uint32_t missed_blocks;
+    double total_votes;
+    producers_table::const_iterator pitr;
+  };
+  std::vector<missed_blocks_key> prods;
+  prods.reserve(active_schedule_size);
 
-  for (auto &pm : _gschedule_metrics.producers_metric) {
+  for (auto &pm : _gschedule_metrics->producers_metric) {
     auto pitr = _producers.find(pm.bp_name.value);
     if (pitr != _producers.end() && pitr->is_active) {
       if (pm.missed_blocks_per_cycle > 0) {
@@ -43,37 +41,35 @@ void system_contract::update_missed_blocks_per_rotation() {
         });
       }
 
-      if (pitr->missed_blocks_per_rotation > 0)
-        prods.emplace_back(*pitr);
+      if (max_kick_bps > 0 && pitr->missed_blocks_per_rotation > 0)
+        prods.push_back({pitr->missed_blocks_per_rotation, pitr->total_votes, pitr});
     }
   }
 
-  std::sort(prods.begin(), prods.end(), [](const producer_info &p1,
-                                           const producer_info &p2) {
-    if (p1.missed_blocks_per_rotation != p2.missed_blocks_per_rotation)
-      return p1.missed_blocks_per_rotation > p2.missed_blocks_per_rotation;
+  // at most max_kick_bps producers can be kicked, so only that many need to be in order
+  auto kick_candidates_end = prods.begin() + std::min<size_t>(max_kick_bps, prods.size());
+  std::partial_sort(prods.begin(), kick_candidates_end, prods.end(),
+                    [](const missed_blocks_key &p1, const missed_blocks_key &p2) {
+    if (p1.missed_blocks != p2.missed_blocks)
+      return p1.missed_blocks > p2.missed_blocks;
     else
       return p1.total_votes < p2.total_votes;
   });
 
-  for (auto &prod : prods) {
-    auto pitr = _producers.find(prod.owner.value);
-
-    if (crossed_missed_blocks_threshold(pitr->missed_blocks_per_rotation,
-                                        uint32_t(active_schedule_size)) &&
-        max_kick_bps > 0) {
-      _producers.modify(pitr, same_payer, [&](auto &p) {
+  for (auto it = prods.begin(); it != kick_candidates_end; ++it) {
+    if (crossed_missed_blocks_threshold(it->missed_blocks,
+                                        uint32_t(active_schedule_size))) {
+      _producers.modify(it->pitr, same_payer, [&](auto &p) {
         p.lifetime_missed_blocks += p.missed_blocks_per_rotation;
         p.kick(kick_type::REACHED_TRESHOLD);
       });
-      max_kick_bps--;
     } else
       break;
   }
 }
 
 void system_contract::restart_missed_blocks_per_rotation(
-    std::vector<producer_location_pair> prods) {
+    const std::vector<producer_location_pair>& prods) {
   // restart all missed blocks to bps and sbps
   for (size_t i = 0; i < prods.size(); i++) {
     auto bp_name = prods[i].first.producer_name;
@@ -95,83 +91,60 @@ void system_contract::restart_missed_blocks_per_rotation(
      return index >= low_bound && index < up_bound;
    } 
 
-std::vector<producer_location_pair> system_contract::check_rotation_state( std::vector<producer_location_pair> prods, block_timestamp block_time) {
+// Returns the positions in `prods` of the producers to schedule, with the rotated out BP replaced by the SBP
+std::vector<uint8_t> system_contract::check_rotation_state( const std::vector<producer_location_pair>& prods, block_timestamp block_time) {
       uint32_t total_active_voted_prods = prods.size(); 
-      std::vector<producer_location_pair>::iterator it_bp = prods.end();
-      std::vector<producer_location_pair>::iterator it_sbp = prods.end();
-
-      if (_grotation.next_rotation_time <= block_time) {
+      const size_t none = prods.size();
+      size_t bp_index = none;
+      size_t sbp_index = none;
 
-        if (total_active_voted_prods > TOP_PRODUCERS) {
-          _grotation.bp_out_index = _grotation.bp_out_index >= TOP_PRODUCERS - 1 ? 0 : _grotation.bp_out_index + 1;
-          _grotation.sbp_in_index = _grotation.sbp_in_index >= total_active_voted_prods - 1 ? TOP_PRODUCERS : _grotation.sbp_in_index + 1;
+      if (_grotation->next_rotation_time <= block_time) {
 
-          name bp_name = prods[_grotation.bp_out_index].first.producer_name;
-          name sbp_name = prods[_grotation.sbp_in_index].first.producer_name;
+        if (total_active_voted_prods > active_schedule_policy::top_producers) {
+          _grotation->bp_out_index = _grotation->bp_out_index >= active_schedule_policy::top_producers - 1 ? 0 : _grotation->bp_out_index + 1;
+          _grotation->sbp_in_index = _grotation->sbp_in_index >= total_active_voted_prods - 1 ? active_schedule_policy::top_producers : _grotation->sbp_in_index + 1;
 
-          it_bp = prods.begin() + int32_t(_grotation.bp_out_index);
-          it_sbp = prods.begin() + int32_t(_grotation.sbp_in_index);
+          bp_index = _grotation->bp_out_index;
+          sbp_index = _grotation->sbp_in_index;
 
-          set_bps_rotation(bp_name, sbp_name);
+          set_bps_rotation(prods[bp_index].first.producer_name, prods[sbp_index].first.producer_name);
         } 
 
         update_rotation_time(block_time);
         restart_missed_blocks_per_rotation(prods);
       }
       else {
-        if(_grotation.bp_currently_out != name(0) && _grotation.sbp_currently_in != name(0)) {
-          auto bp_name = _grotation.bp_currently_out;
-          it_bp = std::find_if(prods.begin(), prods.end(), [&bp_name](const producer_location_pair &g) {
-            return g.first.producer_name == bp_name; 
-          });
-
-          auto sbp_name = _grotation.sbp_currently_in;
-          it_sbp = std::find_if(prods.begin(), prods.end(), [&sbp_name](const producer_location_pair &g) {
-            return g.first.producer_name == sbp_name; 
-          });
-          auto _bp_index = std::distance(prods.begin(), it_bp);
-          auto _sbp_index = std::distance(prods.begin(), it_sbp);
-
-          if(it_bp == prods.end() || it_sbp == prods.end()) {
+        if(_grotation->bp_currently_out != name(0) && _grotation->sbp_currently_in != name(0)) {
+          for (size_t i = 0; i < prods.size() && (bp_index == none || sbp_index == none); ++i) {
+            const auto& producer_name = prods[i].first.producer_name;
+            if (producer_name == _grotation->bp_currently_out) bp_index = i;
+            else if (producer_name == _grotation->sbp_currently_in) sbp_index = i;
+          }
+
+          if(bp_index == none || sbp_index == none) {
               set_bps_rotation(name(0), name(0));
+              bp_index = sbp_index = none;
 
-            if(total_active_voted_prods < TOP_PRODUCERS) {
-              _grotation.bp_out_index = TOP_PRODUCERS;
-              _grotation.sbp_in_index = MAX_PRODUCERS+1;
+            if(total_active_voted_prods < active_schedule_policy::top_producers) {
+              _grotation->bp_out_index = active_schedule_policy::top_producers;
+              _grotation->sbp_in_index = active_schedule_policy::max_producers+1;
             }
-          } else if (total_active_voted_prods > TOP_PRODUCERS && 
-                    (!is_in_range(_bp_index, 0, TOP_PRODUCERS) || !is_in_range(_sbp_index, TOP_PRODUCERS, MAX_PRODUCERS))) {
+          } else if (total_active_voted_prods > active_schedule_policy::top_producers && 
+                    (!is_in_range(bp_index, 0, active_schedule_policy::top_producers) || !is_in_range(sbp_index, active_schedule_policy::top_producers, active_schedule_policy::max_producers))) {
               set_bps_rotation(name(0), name(0));
-              it_bp = prods.end();
-              it_sbp = prods.end();
+              bp_index = sbp_index = none;
           }
         }
     }
 
-      std::vector<producer_location_pair>  top_producers;
+      std::vector<uint8_t> schedule;
+      schedule.reserve(std::min<size_t>(prods.size(), active_schedule_policy::top_producers));
 
       //Rotation
-      if(it_bp != prods.end() && it_sbp != prods.end()) {
-        for ( auto pIt = prods.begin(); pIt != prods.end(); ++pIt) {
-          auto i = std::distance(prods.begin(), pIt); 
-          // print("\ni-> ", i);
-          if(i > TOP_PRODUCERS - 1) break;
-
-          if(pIt->first.producer_name == it_bp->first.producer_name) {
-            // print("\nprod sbp added to schedule -> ", name{it_sbp->producer_name});
-            top_producers.emplace_back(*it_sbp);
-          } else {
-            // print("\nprod bp added to schedule -> ", name{pIt->producer_name});
-            top_producers.emplace_back(*pIt);
-          } 
-        }
-      } 
-      else {
-        top_producers = prods;
-        if(prods.size() > TOP_PRODUCERS) top_producers.resize(TOP_PRODUCERS);
-        else top_producers.resize(prods.size());
+      for (size_t i = 0; i < prods.size() && i < active_schedule_policy::top_producers; ++i) {
+        schedule.push_back(uint8_t(i == bp_index && sbp_index != none ? sbp_index : i));
       }
 
-  return top_producers;
+  return schedule;
 }
 }
@@ -8,8 +8,10 @@
 #include <eosio/singleton.hpp>
 
 #include <eosio.system/eosio.system.hpp>
+#include <eosio.system/vote_weight.hpp>
 #include <eosio.token/eosio.token.hpp>
 
+#include <array>
 #include <type_traits>
 #include <limits>
 #include <set>
@@ -121,15 +123,23 @@ namespace eosiosystem {
    // TELOS END
 
    void system_contract::update_elected_producers( const block_timestamp& block_time ) {
-      _gstate.last_producer_schedule_update = block_time;
+      // TELOS BEGIN
+      // producer totals are partial until a running vote repair finishes, so the schedule is not ranked again;
+      // kicked and unregistered producers are still taken out of it
+      if ( _gvoterepair->in_progress() ) {
+         replace_removed_producers( block_time );
+         return;
+      }
+      // TELOS END
+      _gstate->last_producer_schedule_update = block_time;
 
       auto idx = _producers.get_index<"prototalvote"_n>();
 
       // TELOS BEGIN
       uint32_t totalActiveVotedProds = uint32_t(std::distance(idx.begin(), idx.end()));
-      totalActiveVotedProds = totalActiveVotedProds > MAX_PRODUCERS ? MAX_PRODUCERS : totalActiveVotedProds;
+      totalActiveVotedProds = totalActiveVotedProds > active_schedule_policy::max_producers ? active_schedule_policy::max_producers : totalActiveVotedProds;
 
-      std::vector< producer_location_pair > active_producers, top_producers;
+      std::vector< producer_location_pair > active_producers;
       active_producers.reserve(totalActiveVotedProds);
 
       for( auto it = idx.cbegin(); it != idx.cend() && active_producers.size() < totalActiveVotedProds /*TELOS*/ && 0 < it->total_votes && it->active(); ++it ) {
@@ -142,46 +152,109 @@ namespace eosiosystem {
          );
       }
 
-      if( active_producers.size() == 0 || active_producers.size() < _gstate.last_producer_schedule_size ) {
+      if( active_producers.size() == 0 || active_producers.size() < _gstate->last_producer_schedule_size ) {
          return;
       }
 
-      top_producers = check_rotation_state(active_producers, block_time);
+      // positions into active_producers, so each authority is moved once into the proposed schedule
+      auto top_producers = check_rotation_state(active_producers, block_time);
       // TELOS END
 
-      std::sort( top_producers.begin(), top_producers.end(), []( const producer_location_pair& lhs, const producer_location_pair& rhs ) {
+      std::sort( top_producers.begin(), top_producers.end(), [&]( uint8_t lhs, uint8_t rhs ) {
          //return lhs.first.producer_name < rhs.first.producer_name; // sort by producer name
-         return lhs.second < rhs.second; // TELOS sort by location
+         return active_producers[lhs].second < active_producers[rhs].second; // TELOS sort by location
       } );
 
       std::vector<eosio::producer_authority> producers;
 
       producers.reserve(top_producers.size());
-      for( auto& item : top_producers )
-         producers.push_back( std::move(item.first) );
+      for( auto i : top_producers )
+         producers.push_back( std::move(active_producers[i].first) );
 
-      // TELOS BEGIN
+      propose_producers( producers, block_time ); // TELOS
+   }
+
+   // TELOS BEGIN
+   void system_contract::propose_producers( const std::vector<eosio::producer_authority>& producers, const block_timestamp& block_time ) {
       auto schedule_version = set_proposed_producers(producers);
       if (schedule_version >= 0) {
         print("\n**new schedule was proposed**");
 
-        _gstate.last_proposed_schedule_update = block_time;
-
-        _gschedule_metrics.producers_metric.erase( _gschedule_metrics.producers_metric.begin(), _gschedule_metrics.producers_metric.end());
+        _gstate->last_proposed_schedule_update = block_time;
 
         std::vector<producer_metric> psm;
-        std::for_each(top_producers.begin(), top_producers.end(), [&psm](auto &tp) {
-          auto bp_name = tp.first.producer_name;
-          psm.emplace_back(producer_metric{ bp_name, 12 });
-        });
+        uint64_t fingerprint = 0;
+        psm.reserve(producers.size());
+        for (const auto &p : producers) {
+          psm.emplace_back(producer_metric{ p.producer_name, 12 });
+          fingerprint += producer_fingerprint(p.producer_name);
+        }
 
-        _gschedule_metrics.producers_metric = psm;
+        _gschedule_metrics->producers_metric = std::move(psm);
+        _gschedule_metrics->schedule_fingerprint.emplace(fingerprint);
+        _gschedule_metrics->index_slots();
 
-        _gstate.last_producer_schedule_size = static_cast<decltype(_gstate.last_producer_schedule_size)>(top_producers.size());
+        _gstate->last_producer_schedule_size = static_cast<decltype(_gstate->last_producer_schedule_size)>(producers.size());
       }
-      // TELOS END
    }
 
+   // Keeps the proposed schedule while a vote repair runs, except for producers that are no longer active.
+   // Their seats go to the next active producers by the totals counted so far; rotation is left as it is.
+   void system_contract::replace_removed_producers( const block_timestamp& block_time ) {
+      _gstate->last_producer_schedule_update = block_time;
+
+      const size_t schedule_size = _gschedule_metrics->producers_metric.size();
+
+      std::vector< producer_location_pair > scheduled;
+      scheduled.reserve(schedule_size);
+      for( const auto& pm : _gschedule_metrics->producers_metric ) {
+         auto pitr = _producers.find( pm.bp_name.value );
+         if( pitr != _producers.end() && pitr->active() ) {
+            scheduled.emplace_back(
+               eosio::producer_authority{
+                  .producer_name = pitr->owner,
+                  .authority     = pitr->get_producer_authority()
+               },
+               pitr->location
+            );
+         }
+      }
+
+      if( scheduled.size() == schedule_size ) {
+         return;
+      }
+
+      // totals can still be zero here, so unlike a full update a producer without counted votes can fill a seat
+      auto idx = _producers.get_index<"prototalvote"_n>();
+      for( auto it = idx.cbegin(); it != idx.cend() && scheduled.size() < schedule_size && it->active(); ++it ) {
+         if( _gschedule_metrics->find_metric( it->owner ) == nullptr ) {
+            scheduled.emplace_back(
+               eosio::producer_authority{
+                  .producer_name = it->owner,
+                  .authority     = it->get_producer_authority()
+               },
+               it->location
+            );
+         }
+      }
+
+      if( scheduled.size() == 0 || scheduled.size() < _gstate->last_producer_schedule_size ) {
+         return;
+      }
+
+      std::sort( scheduled.begin(), scheduled.end(), []( const producer_location_pair& lhs, const producer_location_pair& rhs ) {
+         return lhs.second < rhs.second; // sort by location
+      } );
+
+      std::vector<eosio::producer_authority> producers;
+      producers.reserve(scheduled.size());
+      for( auto& p : scheduled )
+         producers.push_back( std::move(p.first) );
+
+      propose_producers( producers, block_time );
+   }
+   // TELOS END
+
    double stake2vote( int64_t staked ) {
       /// TODO subtract 2080 brings the large numbers closer to this decade
       double weight = int64_t( (current_time_point().sec_since_epoch() - (block_timestamp::block_timestamp_epoch / 1000)) / (seconds_per_day * 7) )  / double( 52 );
@@ -193,14 +266,14 @@ namespace eosiosystem {
    * This function caculates the inverse weight voting. 
    * The maximum weighted vote will be reached if an account votes for the maximum number of registered producers (up to 30 in total).  
    */
-   double system_contract::inverse_vote_weight(double staked, double amountVotedProducers) {
-     if (amountVotedProducers == 0.0) {
+   double system_contract::inverse_vote_weight(double staked, size_t amountVotedProducers) {
+     if (amountVotedProducers == 0) {
        return 0;
      }
 
-     double percentVoted = amountVotedProducers / MAX_VOTE_PRODUCERS;
-     double voteWeight = (sin(M_PI * percentVoted - M_PI_2) + 1.0) / 2.0;
-     return (voteWeight * staked);
+     static_assert( vote_weight_factors.size() == active_schedule_policy::max_vote_producers + 1, "one vote weight factor per producer count" );
+     check( amountVotedProducers <= active_schedule_policy::max_vote_producers, "attempt to vote for too many producers" );
+     return (vote_weight_factors[amountVotedProducers] * staked);
    }
    // TELOS END
 
@@ -209,27 +282,27 @@ namespace eosiosystem {
                                                        double shares_rate_delta )
    {
       double delta_total_votepay_share = 0.0;
-      if( ct > _gstate3.last_vpay_state_update ) {
-         delta_total_votepay_share = _gstate3.total_vpay_share_change_rate
-                                       * double( (ct - _gstate3.last_vpay_state_update).count() / 1E6 );
+      if( ct > _gstate3->last_vpay_state_update ) {
+         delta_total_votepay_share = _gstate3->total_vpay_share_change_rate
+                                       * double( (ct - _gstate3->last_vpay_state_update).count() / 1E6 );
       }
 
       delta_total_votepay_share += additional_shares_delta;
-      if( delta_total_votepay_share < 0 && _gstate2.total_producer_votepay_share < -delta_total_votepay_share ) {
-         _gstate2.total_producer_votepay_share = 0.0;
+      if( delta_total_votepay_share < 0 && _gstate2->total_producer_votepay_share < -delta_total_votepay_share ) {
+         _gstate2->total_producer_votepay_share = 0.0;
       } else {
-         _gstate2.total_producer_votepay_share += delta_total_votepay_share;
+         _gstate2->total_producer_votepay_share += delta_total_votepay_share;
       }
 
-      if( shares_rate_delta < 0 && _gstate3.total_vpay_share_change_rate < -shares_rate_delta ) {
-         _gstate3.total_vpay_share_change_rate = 0.0;
+      if( shares_rate_delta < 0 && _gstate3->total_vpay_share_change_rate < -shares_rate_delta ) {
+         _gstate3->total_vpay_share_change_rate = 0.0;
       } else {
-         _gstate3.total_vpay_share_change_rate += shares_rate_delta;
+         _gstate3->total_vpay_share_change_rate += shares_rate_delta;
       }
 
-      _gstate3.last_vpay_state_update = ct;
+      _gstate3->last_vpay_state_update = ct;
 
-      return _gstate2.total_producer_votepay_share;
+      return _gstate2->total_producer_votepay_share;
    }
 
    double system_contract::update_producer_votepay_share( const producers_table2::const_iterator& prod_itr,
@@ -278,6 +351,35 @@ namespace eosiosystem {
    }
 
    void system_contract::voteupdate( const name& voter_name ) {
+      refresh_vote( voter_name );
+   } // voteupdate
+
+   // TELOS BEGIN
+   void system_contract::voteupdates( const std::vector<name>& voters ) {
+      check( !voters.empty(), "voters cannot be empty" );
+
+      producer_vote_deltas batch;
+      batch.deltas.reserve( active_schedule_policy::max_vote_producers );
+      for( const auto& voter_name : voters ) {
+         refresh_vote( voter_name, &batch );
+      }
+
+      for( const auto& [producer, vote_delta] : batch.deltas ) {
+         if( vote_delta == 0 ) {
+            continue;
+         }
+         auto pitr = _producers.find( producer.value );
+         _producers.modify( pitr, same_payer, [&]( auto& p ) {
+            p.total_votes += vote_delta;
+            if ( p.total_votes < 0 ) { // floating point arithmetics can give small negative numbers
+               p.total_votes = 0;
+            }
+         });
+      }
+   } // voteupdates
+   // TELOS END
+
+   void system_contract::refresh_vote( const name& voter_name, producer_vote_deltas* batch ) {
       auto voter = _voters.find( voter_name.value );
       check( voter != _voters.end(), "no voter found" );
 
@@ -290,12 +392,20 @@ namespace eosiosystem {
       if( rex_itr != _rexbalance.end() && rex_itr->rex_balance.amount > 0 ) {
          new_staked += rex_itr->vote_stake.amount;
       }
-      del_bandwidth_table     del_tbl( get_self(), voter_name.value );
 
-      auto del_itr = del_tbl.begin();
-      while(del_itr != del_tbl.end()) {
-         new_staked += del_itr->net_weight.amount + del_itr->cpu_weight.amount;
-         del_itr++;
+      delegated_totals_table totals( get_self(), get_self().value );
+      auto tot_itr = totals.find( voter_name.value );
+      if( tot_itr != totals.end() && tot_itr->reconciled ) {
+         new_staked += tot_itr->delegated;
+      } else {
+         // no reconciled total yet, see reconcilebw
+         del_bandwidth_table     del_tbl( get_self(), voter_name.value );
+
+         auto del_itr = del_tbl.begin();
+         while(del_itr != del_tbl.end()) {
+            new_staked += del_itr->net_weight.amount + del_itr->cpu_weight.amount;
+            del_itr++;
+         }
       }
 
       if( voter->staked != new_staked){
@@ -305,17 +415,18 @@ namespace eosiosystem {
          });
       }
 
-      update_votes(voter_name, voter->proxy, voter->producers, true);
-   } // voteupdate
+      update_votes(voter_name, voter->proxy, voter->producers, true, false, batch);
+   } // refresh_vote
 
 
-   void system_contract::update_votes( const name& voter_name, const name& proxy, const std::vector<name>& producers, bool voting ) {
+   void system_contract::update_votes( const name& voter_name, const name& proxy, const std::vector<name>& producers, bool voting, bool recount,
+                                       producer_vote_deltas* batch ) {
       //validate input
       if ( proxy ) {
          check( producers.size() == 0, "cannot vote for producers and proxy at same time" );
          check( voter_name != proxy, "cannot proxy to self" );
       } else {
-         check( producers.size() <= 30, "attempt to vote for too many producers" );
+         check( producers.size() <= active_schedule_policy::max_vote_producers, "attempt to vote for too many producers" );
          for( size_t i = 1; i < producers.size(); ++i ) {
             check( producers[i-1] < producers[i], "producer votes must be unique and sorted" );
          }
@@ -326,6 +437,33 @@ namespace eosiosystem {
       check( !proxy || !voter->is_proxy, "account registered as a proxy is not allowed to use a proxy" );
 
       // TELOS BEGIN
+      // a running vote repair has not counted this voter yet, so none of its weight is in the tallies;
+      // record the new selection and leave the counting to the repair
+      if ( !is_vote_counted( voter_name ) ) {
+         if ( proxy ) {
+            auto new_proxy = _voters.find( proxy.value );
+            check( new_proxy != _voters.end(), "invalid proxy specified" );
+            check( !voting || new_proxy->is_proxy, "proxy not found" );
+         } else {
+            for( const auto& p : producers ) {
+               auto pitr = _producers.find( p.value );
+               if( pitr == _producers.end() ) {
+                  check( false, ( "producer " + p.to_string() + " is not registered" ).data() );
+               }
+               if( voting && !pitr->active() ) {
+                  check( false, ( "producer " + p.to_string() + " is not currently registered" ).data() );
+               }
+            }
+         }
+         _voters.modify( voter, same_payer, [&]( auto& av ) {
+            av.last_vote_weight = 0;
+            av.last_stake = 0;
+            av.producers = producers;
+            av.proxy     = proxy;
+         });
+         return;
+      }
+
       auto totalStaked = voter->staked;
       if(voter->is_proxy){
          totalStaked += voter->proxied_vote_weight;
@@ -339,13 +477,14 @@ namespace eosiosystem {
 
       // when a voter or a proxy votes or changes stake, the total_activated stake should be re-calculated
       // any proxy stake handling should be done when the proxy votes or on weight propagation
-      // if(_gstate.thresh_activated_stake_time == 0 && !proxy && !voter->proxy){
+      // if(_gstate->thresh_activated_stake_time == 0 && !proxy && !voter->proxy){
       if(!proxy && !voter->proxy){
-         _gstate.total_activated_stake += totalStaked - voter->last_stake;
+         _gstate->total_activated_stake += totalStaked - voter->last_stake;
       }
 
-      auto new_vote_weight = inverse_vote_weight((double)totalStaked, (double) producers.size());
-      std::map<name, std::pair< double, bool > > producer_deltas;
+      auto new_vote_weight = inverse_vote_weight((double)totalStaked, producers.size());
+      bool remove_old_votes = false;
+      bool add_new_votes = false;
 
       // print("\n Voter : ", voter->last_stake, " = ", voter->last_vote_weight, " = ", proxy, " = ", producers.size(), " = ", totalStaked, " = ", new_vote_weight);
 
@@ -363,58 +502,88 @@ namespace eosiosystem {
             // propagate weight here only when switching proxies
             // otherwise propagate happens in the case below
             if( proxy != voter->proxy ) {  
-               _gstate.total_activated_stake += totalStaked - voter->last_stake;
-               propagate_weight_change( *old_proxy );
+               _gstate->total_activated_stake += totalStaked - voter->last_stake;
+               propagate_weight_change( *old_proxy, batch );
             }
          } else {
-            for( const auto& p : voter->producers ) {
-               auto& d = producer_deltas[p];
-               d.first -= voter->last_vote_weight;
-               d.second = false;
-            }
+            remove_old_votes = true;
          }
       }
 
       if( proxy ) {
          auto new_proxy = _voters.find( proxy.value );
          check( new_proxy != _voters.end(), "invalid proxy specified" ); //if ( !voting ) { data corruption } else { wrong vote }
-         check( !voting || new_proxy->is_proxy, "proxy not found" );
+         check( !voting || recount || new_proxy->is_proxy, "proxy not found" ); // a recount keeps the stored proxy
 
          _voters.modify( new_proxy, same_payer, [&]( auto& vp ) {
             vp.proxied_vote_weight += voter->staked;
          });
 
          if((*new_proxy).last_vote_weight > 0){
-            _gstate.total_activated_stake += totalStaked - voter->last_stake;
-            propagate_weight_change( *new_proxy );
+            _gstate->total_activated_stake += totalStaked - voter->last_stake;
+            propagate_weight_change( *new_proxy, batch );
          }
       } else {
-         if( new_vote_weight >= 0 ) {
-            for( const auto& p : producers ) {
-               auto& d = producer_deltas[p]; 
-               d.first += new_vote_weight;
-               d.second = true;
-            }
+         add_new_votes = new_vote_weight >= 0;
+      }
+
+      // both the previous and the new producer lists are sorted and unique, so a single merge
+      // yields one delta per producer in name order
+      struct producer_delta {
+         name     producer;
+         double   vote_delta;
+         bool     from_new_set;
+      };
+      std::array<producer_delta, 2 * active_schedule_policy::max_vote_producers> producer_deltas;
+      size_t delta_count = 0;
+
+      const auto& old_producers = voter->producers;
+      const size_t old_count = remove_old_votes ? old_producers.size() : 0;
+      const size_t new_count = add_new_votes ? producers.size() : 0;
+      check( old_count <= active_schedule_policy::max_vote_producers, "attempt to vote for too many producers" ); // data corruption
+
+      for( size_t i = 0, j = 0; i < old_count || j < new_count; ) {
+         auto& d = producer_deltas[delta_count++];
+         if( j == new_count || ( i < old_count && old_producers[i] < producers[j] ) ) {
+            d = { old_producers[i++], -voter->last_vote_weight, false };
+         } else if( i == old_count || producers[j] < old_producers[i] ) {
+            d = { producers[j++], new_vote_weight, true };
+         } else {
+            d = { producers[j++], new_vote_weight - voter->last_vote_weight, true };
+            ++i;
          }
       }
 
-      for( const auto& pd : producer_deltas ) {
-         auto pitr = _producers.find( pd.first.value );
+      for( size_t k = 0; k < delta_count; ++k ) {
+         const auto& pd = producer_deltas[k];
+         if( pd.vote_delta == 0 && !pd.from_new_set ) {
+            continue;
+         }
+         auto pitr = _producers.find( pd.producer.value );
          if( pitr != _producers.end() ) {
-            if( voting && !pitr->active() && pd.second.second /* from new set */ ) {
+            // a recount restores a stored selection, which may name producers that were removed since
+            if( voting && !recount && !pitr->active() && pd.from_new_set ) {
                check( false, ( "producer " + pitr->owner.to_string() + " is not currently registered" ).data() );
             }
+            if( pd.vote_delta == 0 ) { // re-vote with unchanged weight, nothing to update
+               continue;
+            }
+            if( batch ) { // voteupdates applies the summed delta once per producer
+               batch->add( pd.producer, pd.vote_delta );
+               _gstate->total_producer_vote_weight += pd.vote_delta;
+               continue;
+            }
             _producers.modify( pitr, same_payer, [&]( auto& p ) {
-               p.total_votes += pd.second.first;
+               p.total_votes += pd.vote_delta;
                if ( p.total_votes < 0 ) { // floating point arithmetics can give small negative numbers
                   p.total_votes = 0;
                }
-               _gstate.total_producer_vote_weight += pd.second.first;
+               _gstate->total_producer_vote_weight += pd.vote_delta;
                //check( p.total_votes >= 0, "something bad happened" );
             });
          } else {
-            if( pd.second.second ) {
-               check( false, ( "producer " + pd.first.to_string() + " is not registered" ).data() );
+            if( pd.from_new_set ) {
+               check( false, ( "producer " + pd.producer.to_string() + " is not registered" ).data() );
             }
          }
       }
@@ -453,7 +622,7 @@ namespace eosiosystem {
       }
    }
 
-   void system_contract::propagate_weight_change( const voter_info& voter ) {
+   void system_contract::propagate_weight_change( const voter_info& voter, producer_vote_deltas* batch ) {
       check( !voter.proxy || !voter.is_proxy, "account registered as a proxy is not allowed to use a proxy" );
       // TELOS REPLACE BEGIN
       /*
@@ -481,7 +650,7 @@ namespace eosiosystem {
                const double init_total_votes = prod.total_votes;
                _producers.modify( prod, same_payer, [&]( auto& p ) {
                   p.total_votes += delta;
-                  _gstate.total_producer_vote_weight += delta;
+                  _gstate->total_producer_vote_weight += delta;
                });
                auto prod2 = _producers2.find( acnt.value );
                if ( prod2 != _producers2.end() ) {
@@ -513,71 +682,143 @@ namespace eosiosystem {
          }
       );
       */
-      auto totalStake = voter.staked;
-      if(voter.is_proxy){
-         totalStake += voter.proxied_vote_weight;
-      }
-      double new_weight = inverse_vote_weight((double)totalStake, voter.producers.size());
-      double delta = new_weight - voter.last_vote_weight;
-
-      if (voter.proxy) { // this part should never happen since the function is called only on proxies
-         if(voter.last_stake != totalStake){
-            auto &proxy = _voters.get(voter.proxy.value, "proxy not found"); // data corruption
-            _voters.modify(proxy, same_payer, [&](auto &p) { 
-               p.proxied_vote_weight += totalStake - voter.last_stake;
-            });
+      // walk the proxy chain iteratively instead of recursing; a proxy cannot itself use a proxy,
+      // so a legitimate chain is at most two accounts long
+      static constexpr size_t max_proxy_depth = 2;
+
+      const voter_info* current = &voter;
+      for( size_t depth = 1; ; ++depth ) {
+         check( depth <= max_proxy_depth, "proxy chain is too deep" ); // data corruption
+         if( depth > 1 ) {
+            check( !current->proxy || !current->is_proxy, "account registered as a proxy is not allowed to use a proxy" );
+         }
 
-            propagate_weight_change(proxy);
+         auto totalStake = current->staked;
+         if(current->is_proxy){
+            totalStake += current->proxied_vote_weight;
          }
-      } else {
-         for (auto acnt : voter.producers) {
-            auto &pitr = _producers.get(acnt.value, "producer not found"); // data corruption
-            _producers.modify(pitr, same_payer, [&](auto &p) {
-               p.total_votes += delta;
-               _gstate.total_producer_vote_weight += delta;
-            });
+         const double new_weight = inverse_vote_weight((double)totalStake, current->producers.size());
+         const double delta = new_weight - current->last_vote_weight;
+
+         const voter_info* next = nullptr;
+         if (current->proxy) { // this part should never happen since the function is called only on proxies
+            if(current->last_stake != totalStake){
+               next = &_voters.get(current->proxy.value, "proxy not found"); // data corruption
+               _voters.modify(*next, same_payer, [&](auto &p) {
+                  p.proxied_vote_weight += totalStake - current->last_stake;
+               });
+            }
+         } else if (delta != 0) {
+            for (const auto& acnt : current->producers) {
+               auto &pitr = _producers.get(acnt.value, "producer not found"); // data corruption
+               if (batch) { // voteupdates applies the summed delta once per producer
+                  batch->add(acnt, delta);
+                  _gstate->total_producer_vote_weight += delta;
+                  continue;
+               }
+               _producers.modify(pitr, same_payer, [&](auto &p) {
+                  p.total_votes += delta;
+                  _gstate->total_producer_vote_weight += delta;
+               });
+            }
          }
-      }
 
-      _voters.modify(voter, same_payer, [&](auto &v) { 
-         v.last_vote_weight = new_weight; 
-         v.last_stake = totalStake;
-      });
+         _voters.modify(*current, same_payer, [&](auto &v) {
+            v.last_vote_weight = new_weight;
+            v.last_stake = totalStake;
+         });
+
+         if( !next ) {
+            break;
+         }
+         current = next;
+      }
       // TELOS REPLACE END
    }
 
    // TELOS BEGIN
-   void system_contract::recalculate_votes(){
-    if (_gstate.total_producer_vote_weight <= -0.1){ // -0.1 threshold for floating point calc ?
-        _gstate.total_producer_vote_weight = 0;
-        _gstate.total_activated_stake = 0;
-        for(auto producer = _producers.begin(); producer != _producers.end(); ++producer){
-            _producers.modify(producer, same_payer, [&](auto &p) {
-                p.total_votes = 0;
+   void system_contract::recalculate_votes() {
+      if ( !_gvoterepair->in_progress() ) {
+         if ( _gstate->total_producer_vote_weight > -0.1 ) { // -0.1 threshold for floating point calc ?
+            return;
+         }
+         _gstate->total_producer_vote_weight = 0;
+         _gstate->total_activated_stake = 0;
+         _gvoterepair->stage = vote_repair_state::reset_producers;
+         _gvoterepair->cursor = name(0);
+      }
+      repair_votes( vote_repair_state::rows_per_block );
+   }
+
+   void system_contract::repairvotes( uint16_t max ) {
+      check( _gvoterepair->in_progress(), "no vote repair in progress" );
+      check( max > 0, "max must be greater than 0" );
+      repair_votes( max );
+   }
+
+   bool system_contract::is_vote_counted( const name& voter )const {
+      if ( !_gvoterepair->in_progress() ) {
+         return true;
+      }
+      return _gvoterepair->stage == vote_repair_state::recount_voters && voter.value < _gvoterepair->cursor.value;
+   }
+
+   /**
+    * Advances the vote recount by at most `max_rows` producer or voter rows.
+    *
+    * Producer totals are zeroed first, then every voter's last vote weight is cleared, and finally every voter
+    * is counted again through update_votes. Voters are counted in primary key order, so the cursor tells which
+    * voters are already part of the producer totals (see is_vote_counted).
+    */
+   uint32_t system_contract::repair_votes( uint32_t max_rows ) {
+      uint32_t processed = 0;
+
+      if ( _gvoterepair->stage == vote_repair_state::reset_producers ) {
+         auto itr = _producers.lower_bound( _gvoterepair->cursor.value );
+         for( ; itr != _producers.end() && processed < max_rows; ++itr, ++processed ) {
+            _producers.modify( itr, same_payer, [&](auto &p) {
+               p.total_votes = 0;
             });
-        }
-        std::map< name, bool> processed_proxies;
-        for (auto voter = _voters.begin(); voter != _voters.end(); ++voter) {
-            if(voter->proxy && !processed_proxies[voter->proxy]){
-                auto proxy = _voters.find(voter->proxy.value);
-                _voters.modify( proxy, same_payer, [&]( auto& av ) {
-                    av.last_vote_weight = 0;
-                    av.last_stake = 0;
-                    av.proxied_vote_weight = 0;
-                });
-                processed_proxies[voter->proxy] = true;
-            }
-            if(!voter->is_proxy || !processed_proxies[voter->owner]){
-                _voters.modify( voter, same_payer, [&]( auto& av ) {
-                    av.last_vote_weight = 0;
-                    av.last_stake = 0;
-                    av.proxied_vote_weight = 0;
-                });
-                processed_proxies[voter->owner] = true;
-            }
-            update_votes(voter->owner, voter->proxy, voter->producers, true);
-        }
-    }
+         }
+         if ( itr == _producers.end() ) {
+            _gvoterepair->stage = vote_repair_state::reset_voters;
+            _gvoterepair->cursor = name(0);
+         } else {
+            _gvoterepair->cursor = itr->owner;
+         }
+      }
+
+      if ( _gvoterepair->stage == vote_repair_state::reset_voters ) {
+         auto itr = _voters.lower_bound( _gvoterepair->cursor.value );
+         for( ; itr != _voters.end() && processed < max_rows; ++itr, ++processed ) {
+            _voters.modify( itr, same_payer, [&]( auto& av ) {
+               av.last_vote_weight = 0;
+               av.last_stake = 0;
+               av.proxied_vote_weight = 0;
+            });
+         }
+         if ( itr == _voters.end() ) {
+            _gvoterepair->stage = vote_repair_state::recount_voters;
+            _gvoterepair->cursor = name(0);
+         } else {
+            _gvoterepair->cursor = itr->owner;
+         }
+      }
+
+      if ( _gvoterepair->stage == vote_repair_state::recount_voters ) {
+         auto itr = _voters.lower_bound( _gvoterepair->cursor.value );
+         for( ; itr != _voters.end() && processed < max_rows; ++itr, ++processed ) {
+            // move the cursor past this voter first so update_votes treats it as counted
+            _gvoterepair->cursor = name( itr->owner.value + 1 );
+            update_votes( itr->owner, itr->proxy, itr->producers, true, true );
+         }
+         if ( itr == _voters.end() ) {
+            _gvoterepair->stage = vote_repair_state::idle;
+            _gvoterepair->cursor = name(0);
+         }
+      }
+
+      return processed;
    }
    // TELOS END
 
@@ -87,9 +87,59 @@ struct latest_block_batch_info_result
 #endif
 };
 
-using input_type = std::variant<get_latest_block_batch_info>;
+/**
+ * @brief Input data structure for `get_recorded_block` RPC
+ *
+ * @details Looks up the recorded timestamp of block `block_height`. That call will return the result as the
+ * `recorded_block_result` struct.
+ */
+struct get_recorded_block
+{
+   uint32_t block_height;
+};
+
+/**
+ * @brief Input data structure for `get_recorded_block_at_or_before` RPC
+ *
+ * @details Looks up the latest recorded block produced at or before `timestamp`. That call will return the result as
+ * the `recorded_block_result` struct.
+ */
+struct get_recorded_block_at_or_before
+{
+   time_point timestamp;
+};
+
+#ifdef TEST_INCLUDE
+
+struct recorded_block
+{
+   uint32_t   block_height;
+   time_point block_timestamp;
+};
+
+#else
+
+using eosiosystem::block_info::recorded_block;
+
+#endif
+
+/**
+ * @brief Output data structure for `get_recorded_block` and `get_recorded_block_at_or_before` RPCs
+ */
+struct recorded_block_result
+{
+   std::optional<recorded_block> result;
+
+#ifndef TEST_INCLUDE
+
+   EOSLIB_SERIALIZE(recorded_block_result, (result))
+
+#endif
+};
+
+using input_type = std::variant<get_latest_block_batch_info, get_recorded_block, get_recorded_block_at_or_before>;
 
-using output_type = std::variant<latest_block_batch_info_result>;
+using output_type = std::variant<latest_block_batch_info_result, recorded_block_result>;
 
 } // namespace system_contracts::testing::test_contracts::blockinfo_tester
 
@@ -104,5 +154,10 @@ FC_REFLECT_ENUM(
    (no_error)(invalid_input)(unsupported_version)(insufficient_data))
 FC_REFLECT(system_contracts::testing::test_contracts::blockinfo_tester::latest_block_batch_info_result,
            (result)(error_code))
+FC_REFLECT(system_contracts::testing::test_contracts::blockinfo_tester::get_recorded_block, (block_height))
+FC_REFLECT(system_contracts::testing::test_contracts::blockinfo_tester::get_recorded_block_at_or_before, (timestamp))
+FC_REFLECT(system_contracts::testing::test_contracts::blockinfo_tester::recorded_block,
+           (block_height)(block_timestamp))
+FC_REFLECT(system_contracts::testing::test_contracts::blockinfo_tester::recorded_block_result, (result))
 
 #endif
\ No newline at end of file
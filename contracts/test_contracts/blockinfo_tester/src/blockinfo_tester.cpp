@@ -37,6 +37,16 @@ auto process(get_latest_block_batch_info request) -> latest_block_batch_info_res
    return response;
 }
 
+auto process(get_recorded_block request) -> recorded_block_result
+{
+   return recorded_block_result{.result = block_info::get_recorded_block(request.block_height)};
+}
+
+auto process(get_recorded_block_at_or_before request) -> recorded_block_result
+{
+   return recorded_block_result{.result = block_info::get_recorded_block_at_or_before(request.timestamp)};
+}
+
 output_type process_call(input_type input)
 {
    return std::visit([](auto&& arg) -> output_type { return process(std::move(arg)); }, std::move(input));
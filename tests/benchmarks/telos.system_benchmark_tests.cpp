@@ -0,0 +1,301 @@
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+
+#include <fc/io/json.hpp>
+
+#include "../eosio.system_tester.hpp"
+
+/*
+ * Cost regression benchmarks for the hot system contract actions, built as the benchmark_test executable. They are
+ * only registered with ctest, under the `benchmark` label, when configured with TELOS_BENCHMARKS=ON (then run them
+ * with `ctest -L benchmark`); otherwise run benchmark_test directly.
+ *
+ * Every action is driven on a fresh chain for each population size, and the billed CPU, elapsed time, NET and
+ * RAM delta of its transaction are recorded. When BENCHMARK_REPORT is set, the results are written as JSON to
+ * the file it names.
+ *
+ * The results are compared against tests/benchmarks/baseline.json, or the file named by BENCHMARK_BASELINE.
+ * RAM deltas are deterministic and must not exceed their baseline at all. CPU and elapsed time depend on the
+ * machine, so they are only compared when BENCHMARK_CHECK_CPU is set, with a margin of BENCHMARK_TOLERANCE
+ * percent (default 20). An entry without a baseline is only reported; to record one, run the suite with
+ * BENCHMARK_REPORT set and copy the report over baseline.json.
+ *
+ * BENCHMARK_POPULATIONS overrides the population sizes, as a comma separated list (default 1,10,30).
+ */
+
+using namespace eosio_system;
+
+namespace {
+
+static constexpr int64_t powerup_frac = 1'000'000'000'000'000ll; // 1.0 = 10^15
+
+struct benchmark_sample {
+   std::string key;
+   int64_t     elapsed_us   = 0;
+   uint32_t    cpu_usage_us = 0;
+   uint64_t    net_usage    = 0;
+   int64_t     ram_delta    = 0;
+};
+
+class benchmark_report {
+public:
+   void record( const std::string& action, uint32_t population, const transaction_trace_ptr& trace ) {
+      BOOST_REQUIRE_MESSAGE( bool(trace) && trace->receipt, action << " produced no transaction trace" );
+      BOOST_REQUIRE_EQUAL( transaction_receipt::executed, trace->receipt->status );
+
+      benchmark_sample s;
+      s.key          = action + "/" + std::to_string(population);
+      s.elapsed_us   = trace->elapsed.count();
+      s.cpu_usage_us = trace->receipt->cpu_usage_us;
+      s.net_usage    = trace->net_usage;
+      for( const auto& at : trace->action_traces ) {
+         for( const auto& d : at.account_ram_deltas ) {
+            s.ram_delta += d.delta;
+         }
+      }
+      BOOST_TEST_MESSAGE( s.key << ": cpu " << s.cpu_usage_us << "us, elapsed " << s.elapsed_us
+                          << "us, net " << s.net_usage << " bytes, ram " << s.ram_delta << " bytes" );
+      _samples.push_back( std::move(s) );
+   }
+
+   void write( const std::string& path ) const {
+      fc::mutable_variant_object report;
+      for( const auto& s : _samples ) {
+         report( s.key, fc::mutable_variant_object()
+                        ("cpu_usage_us", s.cpu_usage_us)
+                        ("elapsed_us", s.elapsed_us)
+                        ("net_usage", s.net_usage)
+                        ("ram_delta", s.ram_delta) );
+      }
+      fc::json::save_to_file( fc::variant(report), path, true );
+   }
+
+   void compare( const fc::variant_object& baseline, double tolerance, bool check_cpu ) const {
+      const auto exceeds = [&]( int64_t value, const fc::variant& base ) {
+         return double(value) > base.as_double() * ( 1.0 + tolerance / 100.0 );
+      };
+      for( const auto& s : _samples ) {
+         auto itr = baseline.find( s.key );
+         if( itr == baseline.end() ) {
+            BOOST_TEST_MESSAGE( s.key << ": no baseline, record one with BENCHMARK_REPORT" );
+            continue;
+         }
+         const auto& base = itr->value().get_object();
+         BOOST_CHECK_MESSAGE( s.ram_delta <= base["ram_delta"].as_int64(),
+                              s.key << ": ram " << s.ram_delta << " exceeds baseline " << base["ram_delta"].as_int64() );
+         if( check_cpu ) {
+            BOOST_CHECK_MESSAGE( !exceeds( s.cpu_usage_us, base["cpu_usage_us"] ),
+                                 s.key << ": cpu " << s.cpu_usage_us << "us exceeds baseline " << base["cpu_usage_us"].as_int64() << "us" );
+            BOOST_CHECK_MESSAGE( !exceeds( s.elapsed_us, base["elapsed_us"] ),
+                                 s.key << ": elapsed " << s.elapsed_us << "us exceeds baseline " << base["elapsed_us"].as_int64() << "us" );
+         }
+      }
+   }
+
+private:
+   std::vector<benchmark_sample> _samples;
+};
+
+std::string env_or( const char* var, const std::string& fallback ) {
+   const char* value = std::getenv( var );
+   return value && *value ? std::string(value) : fallback;
+}
+
+std::vector<uint32_t> benchmark_populations() {
+   std::vector<uint32_t> populations;
+   std::stringstream ss( env_or( "BENCHMARK_POPULATIONS", "1,10,30" ) );
+   for( std::string item; std::getline( ss, item, ',' ); ) {
+      populations.push_back( std::stoul( item ) );
+   }
+   return populations;
+}
+
+// eosio_system_tester with a population of registered producers and voters
+class benchmark_tester : public eosio_system_tester {
+public:
+   explicit benchmark_tester( uint32_t population ) {
+      for( uint32_t i = 0; i < population; ++i ) {
+         producers.emplace_back( "tprod" + toBase31(i) );
+         voters.emplace_back( "tvote" + toBase31(i) );
+      }
+      setup_producer_accounts( producers );
+      for( const auto& p : producers ) {
+         BOOST_REQUIRE_EQUAL( success(), regproducer(p) );
+      }
+      setup_producer_accounts( voters );
+      for( const auto& v : voters ) {
+         transfer( config::system_account_name, v, core_sym::from_string("100000.0000"), config::system_account_name );
+      }
+      activate_network();
+      // keep the latest traces, for the transactions the tester does not hand back
+      _trace_connection = control->applied_transaction.connect(
+         [&]( std::tuple<const transaction_trace_ptr&, const packed_transaction_ptr&> t ) {
+            const auto& trace = std::get<0>(t);
+            if( !trace->action_traces.empty() && trace->action_traces[0].act.name == "onblock"_n ) {
+               last_onblock = trace;
+            } else {
+               last_trace = trace;
+            }
+         } );
+   }
+
+   ~benchmark_tester() {
+      _trace_connection.disconnect();
+   }
+
+   transaction_trace_ptr trace_action( const account_name& signer, const action_name& act, const variant_object& data ) {
+      return base_tester::push_action( config::system_account_name, act, signer, data );
+   }
+
+   // proposes, approves and executes a token transfer from `proposer` through eosio.msig, returns the exec trace
+   transaction_trace_ptr trace_msig_exec( const name& proposer ) {
+      abi_serializer msig_abi_ser = initialize_multisig();
+      const auto push_action_msig = [&]( const action_name& act_name, const variant_object& data ) {
+         action act;
+         act.account = "eosio.msig"_n;
+         act.name = act_name;
+         act.data = msig_abi_ser.variant_to_binary( msig_abi_ser.get_action_type(act_name), data, abi_serializer::create_yield_function(abi_serializer_max_time) );
+         BOOST_REQUIRE_EQUAL( success(), base_tester::push_action( std::move(act), proposer.to_uint64_t() ) );
+      };
+
+      transaction trx;
+      fc::variant pretty_trx = mvo()
+         ("expiration", time_point_sec( control->head_block_time() + fc::hours(1) ))
+         ("ref_block_num", 2)
+         ("ref_block_prefix", 3)
+         ("net_usage_words", 0)
+         ("max_cpu_usage_ms", 0)
+         ("delay_sec", 0)
+         ("actions", fc::variants({
+               mvo()
+                  ("account", "eosio.token")
+                  ("name", "transfer")
+                  ("authorization", vector<permission_level>{ { proposer, config::active_name } })
+                  ("data", mvo()
+                     ("from", proposer)
+                     ("to", "alice1111111")
+                     ("quantity", core_sym::from_string("1.0000"))
+                     ("memo", "benchmark") )
+               })
+         );
+      abi_serializer::from_variant( pretty_trx, trx, get_resolver(), abi_serializer::create_yield_function(abi_serializer_max_time) );
+
+      push_action_msig( "propose"_n, mvo()
+                        ("proposer", proposer)
+                        ("proposal_name", "bench")
+                        ("trx", trx)
+                        ("requested", vector<permission_level>{ { proposer, config::active_name } }) );
+      push_action_msig( "approve"_n, mvo()
+                        ("proposer", proposer)
+                        ("proposal_name", "bench")
+                        ("level", permission_level{ proposer, config::active_name }) );
+      push_action_msig( "exec"_n, mvo()
+                        ("proposer", proposer)
+                        ("proposal_name", "bench")
+                        ("executer", proposer) );
+      return last_trace;
+   }
+
+   std::vector<name>     producers;
+   std::vector<name>     voters;
+   transaction_trace_ptr last_onblock;
+   transaction_trace_ptr last_trace;
+
+private:
+   boost::signals2::connection _trace_connection;
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(telos_system_benchmark_tests)
+
+BOOST_AUTO_TEST_CASE(system_action_costs) try {
+   benchmark_report report;
+
+   for( const uint32_t population : benchmark_populations() ) {
+      benchmark_tester t( population );
+      const name voter = t.voters.front();
+      std::vector<name> voted( t.producers.begin(), t.producers.begin() + std::min<size_t>( t.producers.size(), 30 ) );
+      std::sort( voted.begin(), voted.end() );
+
+      report.record( "delegatebw", population, t.trace_action( voter, "delegatebw"_n, mvo()
+                                                               ("from", voter)
+                                                               ("receiver", voter)
+                                                               ("stake_net_quantity", core_sym::from_string("1000.0000"))
+                                                               ("stake_cpu_quantity", core_sym::from_string("1000.0000"))
+                                                               ("transfer", false) ) );
+
+      // everyone votes, so that the last vote and onblock run against a full tally
+      for( const auto& v : t.voters ) {
+         if( v == voter ) continue;
+         BOOST_REQUIRE_EQUAL( t.success(), t.stake( v, v, core_sym::from_string("1000.0000"), core_sym::from_string("1000.0000") ) );
+         BOOST_REQUIRE_EQUAL( t.success(), t.vote( v, voted ) );
+      }
+      report.record( "voteproducer", population, t.trace_action( voter, "voteproducer"_n, mvo()
+                                                                 ("voter", voter)
+                                                                 ("proxy", name(0))
+                                                                 ("producers", voted) ) );
+
+      t.produce_block();
+      report.record( "onblock", population, t.last_onblock );
+
+      BOOST_REQUIRE_EQUAL( t.success(), t.deposit( voter, core_sym::from_string("1000.0000") ) );
+      report.record( "buyrex", population, t.trace_action( voter, "buyrex"_n, mvo()
+                                                           ("from", voter)
+                                                           ("amount", core_sym::from_string("1000.0000")) ) );
+      report.record( "rexexec", population, t.trace_action( voter, "rexexec"_n, mvo()
+                                                            ("user", voter)
+                                                            ("max", 2) ) );
+
+      t.create_account_with_resources( "eosio.reserv"_n, config::system_account_name );
+      const auto resource_config = [&] {
+         return mvo()
+            ("current_weight_ratio", powerup_frac)
+            ("target_weight_ratio", powerup_frac / 100)
+            ("assumed_stake_weight", 1000000000000ll)
+            ("target_timestamp", time_point_sec( t.control->head_block_time() + fc::days(100) ))
+            ("exponent", 2)
+            ("decay_secs", fc::days(1).to_seconds())
+            ("min_price", core_sym::from_string("0.0000"))
+            ("max_price", core_sym::from_string("1000000.0000"));
+      };
+      t.trace_action( config::system_account_name, "cfgpowerup"_n, mvo()("args", mvo()
+                                                                       ("net", resource_config())
+                                                                       ("cpu", resource_config())
+                                                                       ("powerup_days", 30)
+                                                                       ("min_powerup_fee", core_sym::from_string("1.0000")) ) );
+      report.record( "powerup", population, t.trace_action( voter, "powerup"_n, mvo()
+                                                            ("payer", voter)
+                                                            ("receiver", voter)
+                                                            ("days", 30)
+                                                            ("net_frac", powerup_frac / 1000)
+                                                            ("cpu_frac", powerup_frac / 1000)
+                                                            ("max_payment", core_sym::from_string("1000.0000")) ) );
+
+      report.record( "msig_exec", population, t.trace_msig_exec( voter ) );
+
+      // claimrewards pays out what the hourly snapshot in onblock recorded
+      t.transfer( config::system_account_name, "exrsrv.tf"_n, core_sym::from_string("100000000.0000"), config::system_account_name );
+      t.produce_blocks( 3600 + 1 );
+      const auto paid = std::find_if( t.producers.begin(), t.producers.end(), [&]( const name& p ) {
+         return !t.get_payment_info( p ).is_null();
+      } );
+      BOOST_REQUIRE_MESSAGE( paid != t.producers.end(), "claimrewards/" << population << ": no producer was paid" );
+      report.record( "claimrewards", population, t.trace_action( *paid, "claimrewards"_n, mvo()("owner", *paid) ) );
+   }
+
+   const std::string report_path = env_or( "BENCHMARK_REPORT", "" );
+   if( !report_path.empty() ) {
+      report.write( report_path );
+      BOOST_TEST_MESSAGE( "benchmark report written to " << report_path );
+   }
+
+   const std::string baseline_path = env_or( "BENCHMARK_BASELINE", system_contracts::testing::benchmark_baseline_path() );
+   const double tolerance = std::stod( env_or( "BENCHMARK_TOLERANCE", "20" ) );
+   report.compare( fc::json::from_file( baseline_path ).get_object(), tolerance, std::getenv( "BENCHMARK_CHECK_CPU" ) != nullptr );
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <functional>
 #include <limits>
 
@@ -32,11 +33,20 @@ struct block_info_record
    }
 };
 
+struct block_info_slot
+{
+   uint8_t        version = 0;
+   uint32_t       slot;
+   uint32_t       block_height;
+   fc::time_point block_timestamp;
+};
+
 static constexpr uint32_t rolling_window_size = 10;
 
 } // namespace
 
 FC_REFLECT(block_info_record, (version)(block_height)(block_timestamp))
+FC_REFLECT(block_info_slot, (version)(slot)(block_height)(block_timestamp))
 
 namespace {
 
@@ -45,7 +55,9 @@ using namespace system_contracts::testing;
 
 namespace blockinfo_tester = test_contracts::blockinfo_tester;
 
-static const eosio::chain::name blockinfo_table_name = "blockinfo"_n;
+static const eosio::chain::name blockinfo_table_name   = "blockinfo"_n;
+static const eosio::chain::name blockring_table_name   = "blockring"_n;
+static const eosio::chain::name blockwindow_table_name = "blockwindow"_n;
 
 // cspell:disable-next-line
 static const eosio::chain::name blockinfo_tester_account_name = "binfotester"_n;
@@ -53,13 +65,13 @@ static const eosio::chain::name blockinfo_tester_account_name = "binfotester"_n;
 struct block_info_tester : eosio_system::eosio_system_tester
 {
 private:
-   std::optional<eosio::chain::table_id_object::id_type> get_blockinfo_table_id() const
+   std::optional<eosio::chain::table_id_object::id_type> get_table_id(eosio::chain::name table_name) const
    {
       const auto* table_id_itr = control->db().find<eosio::chain::table_id_object, eosio::chain::by_code_scope_table>(
-         boost::make_tuple(eosio::chain::config::system_account_name, eosio::chain::name{0}, blockinfo_table_name));
+         boost::make_tuple(eosio::chain::config::system_account_name, eosio::chain::name{0}, table_name));
 
       if (!table_id_itr) {
-         // No blockinfo table exists.
+         // No such table exists.
          return {};
       }
 
@@ -70,64 +82,100 @@ public:
    block_info_tester() : eosio_system_tester(eosio_system_tester::setup_level::deploy_contract) {}
 
    /**
-    * Scans filtered rows in blockinfo table in order of ascending block height where filtering only picks rows
-    * corresponding to block heights in the closed interval [start_block_height, end_block_height].
-    *
-    * For each row visited, its deserialized block_info_record structure is passed into the visitor function.
-    * If a call to the visitor function returns false, scanning will stop and this function will return.
-    *
-    * @pre start_block_height <= end_block_height
-    * @returns number of rows visited
+    * Returns the rows of the blockinfo table, which contracts built against the previous block_info.hpp read directly,
+    * in order of ascending block height.
     */
-   unsigned int scan_blockinfo_table(uint32_t                               start_block_height,
-                                     uint32_t                               end_block_height,
-                                     std::function<bool(block_info_record)> visitor) const
+   std::vector<block_info_record> get_blockinfo_table() const
    {
-      FC_ASSERT(start_block_height <= end_block_height, "invalid inputs");
+      std::vector<block_info_record> result;
 
-      auto t_id = get_blockinfo_table_id();
+      auto t_id = get_table_id(blockinfo_table_name);
       if (!t_id) {
-         // No blockinfo table exists, so there is nothing to scan through.
-         return 0;
+         // No blockinfo table exists, so no block has been recorded.
+         return result;
       }
 
       const auto& idx = control->db().get_index<eosio::chain::key_value_index, eosio::chain::by_scope_primary>();
 
-      unsigned int rows_visited = 0;
-
       block_info_record r;
 
-      for (auto itr = idx.lower_bound(boost::make_tuple(*t_id, static_cast<uint64_t>(start_block_height)));
-           itr != idx.end() && itr->t_id == *t_id && itr->primary_key <= end_block_height; ++itr) //
+      for (auto itr = idx.lower_bound(boost::make_tuple(*t_id, uint64_t{0})); itr != idx.end() && itr->t_id == *t_id;
+           ++itr) //
       {
          fc::datastream<const char*> ds(itr->value.data(), itr->value.size());
          fc::raw::unpack(ds, r);
-         ++rows_visited;
-         if (!visitor(std::move(r))) {
-            break;
-         }
+         BOOST_REQUIRE_EQUAL(itr->primary_key, r.block_height);
+         result.push_back(r);
       }
 
-      return rows_visited;
+      return result;
    }
 
-   std::vector<block_info_record> get_blockinfo_table()
+   /**
+    * Returns the blocks recorded in the slots of the blockring table, in order of ascending block height.
+    */
+   std::vector<block_info_record> get_blockring_table() const
    {
       std::vector<block_info_record> result;
 
-      scan_blockinfo_table(0, std::numeric_limits<uint32_t>::max(), [&result](const block_info_record& r) {
-         result.push_back(r);
-         return true;
+      auto t_id = get_table_id(blockring_table_name);
+      if (!t_id) {
+         // No blockring table exists, so no block has been recorded.
+         return result;
+      }
+
+      const auto& idx = control->db().get_index<eosio::chain::key_value_index, eosio::chain::by_scope_primary>();
+
+      block_info_slot r;
+
+      for (auto itr = idx.lower_bound(boost::make_tuple(*t_id, uint64_t{0})); itr != idx.end() && itr->t_id == *t_id;
+           ++itr) //
+      {
+         fc::datastream<const char*> ds(itr->value.data(), itr->value.size());
+         fc::raw::unpack(ds, r);
+         BOOST_REQUIRE_EQUAL(itr->primary_key, r.slot);
+         result.push_back(block_info_record{
+            .version         = r.version,
+            .block_height    = r.block_height,
+            .block_timestamp = r.block_timestamp,
+         });
+      }
+
+      std::sort(result.begin(), result.end(), [](const block_info_record& lhs, const block_info_record& rhs) {
+         return lhs.block_height < rhs.block_height;
       });
 
       return result;
    }
 
-   std::pair<std::optional<blockinfo_tester::latest_block_batch_info_result>, eosio::chain::transaction_trace_ptr>
-   get_latest_block_batch_info(blockinfo_tester::get_latest_block_batch_info request)
+   size_t get_blockring_size() const
    {
-      std::pair<std::optional<blockinfo_tester::latest_block_batch_info_result>, eosio::chain::transaction_trace_ptr>
-         result;
+      auto t_id = get_table_id(blockring_table_name);
+      if (!t_id) {
+         return 0;
+      }
+
+      const auto& idx = control->db().get_index<eosio::chain::key_value_index, eosio::chain::by_scope_primary>();
+
+      size_t size = 0;
+      for (auto itr = idx.lower_bound(boost::make_tuple(*t_id, uint64_t{0})); itr != idx.end() && itr->t_id == *t_id;
+           ++itr) {
+         ++size;
+      }
+      return size;
+   }
+
+   bool has_blockwindow() const { return get_table_id(blockwindow_table_name).has_value(); }
+
+   action_result setblockwin(uint32_t window_size)
+   {
+      return push_action(config::system_account_name, "setblockwin"_n, mvo()("window_size", window_size));
+   }
+
+   template <typename Response, typename Request>
+   std::pair<std::optional<Response>, eosio::chain::transaction_trace_ptr> call_blockinfo_tester(Request request)
+   {
+      std::pair<std::optional<Response>, eosio::chain::transaction_trace_ptr> result;
 
       signed_transaction trx;
       trx.actions.emplace_back(std::vector<permission_level>{{config::system_account_name, config::active_name}},
@@ -223,7 +271,7 @@ public:
       fc::raw::unpack(ds, output);
 
       // Ensure the expected return type is returned by the contract.
-      if (auto response_ptr = std::get_if<blockinfo_tester::latest_block_batch_info_result>(&output)) {
+      if (auto response_ptr = std::get_if<Response>(&output)) {
          result.first.emplace(std::move(*response_ptr));
          return result;
       }
@@ -231,6 +279,35 @@ public:
       // Otherwise, something has gone wrong.
       return result;
    }
+
+   std::pair<std::optional<blockinfo_tester::latest_block_batch_info_result>, eosio::chain::transaction_trace_ptr>
+   get_latest_block_batch_info(blockinfo_tester::get_latest_block_batch_info request)
+   {
+      return call_blockinfo_tester<blockinfo_tester::latest_block_batch_info_result>(std::move(request));
+   }
+
+   std::optional<blockinfo_tester::recorded_block> get_recorded_block(uint32_t block_height)
+   {
+      auto result = call_blockinfo_tester<blockinfo_tester::recorded_block_result>(
+         blockinfo_tester::get_recorded_block{.block_height = block_height});
+      BOOST_REQUIRE(result.first.has_value());
+      return result.first->result;
+   }
+
+   std::optional<blockinfo_tester::recorded_block> get_recorded_block_at_or_before(fc::time_point timestamp)
+   {
+      auto result = call_blockinfo_tester<blockinfo_tester::recorded_block_result>(
+         blockinfo_tester::get_recorded_block_at_or_before{.timestamp = timestamp});
+      BOOST_REQUIRE(result.first.has_value());
+      return result.first->result;
+   }
+
+   void deploy_blockinfo_tester()
+   {
+      create_account_with_resources(blockinfo_tester_account_name, config::system_account_name,
+                                    core_sym::from_string("10.0000"), false);
+      set_code(blockinfo_tester_account_name, test_contracts::blockinfo_tester_wasm());
+   }
 };
 
 bool check_tables_match(const std::vector<block_info_record>& expected_table,
@@ -310,6 +387,68 @@ try {
    actual_table = get_blockinfo_table();
    BOOST_CHECK(rolling_window_size == actual_table.size());
    BOOST_CHECK(check_tables_match(expected_table, actual_table));
+
+   // At the default window the blockinfo table is the only per-block record.
+   BOOST_CHECK_EQUAL(0u, get_blockring_size());
+   BOOST_CHECK(!has_blockwindow());
+}
+FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(blockinfo_window_tests, block_info_tester)
+try {
+   deploy_blockinfo_tester();
+
+   produce_blocks(rolling_window_size + 2);
+   BOOST_REQUIRE_EQUAL(0u, get_blockring_size());
+
+   BOOST_REQUIRE_EQUAL(wasm_assert_msg("window_size is unchanged"), setblockwin(rolling_window_size));
+   BOOST_REQUIRE_EQUAL(wasm_assert_msg("window_size exceeds the maximum rolling window size"), setblockwin(7201));
+   BOOST_REQUIRE_EQUAL(wasm_assert_msg("window_size is below the blockinfo window size"),
+                       setblockwin(rolling_window_size - 1));
+
+   auto check_latest_blocks = [this](uint32_t window_size) {
+      auto actual_table = get_blockring_table();
+      BOOST_REQUIRE_EQUAL(window_size, actual_table.size());
+      BOOST_REQUIRE(control->head_block_num() <= actual_table.back().block_height);
+
+      uint32_t expected_height = actual_table.back().block_height - window_size + 1;
+      for (const auto& r : actual_table) {
+         BOOST_CHECK_EQUAL(expected_height, r.block_height);
+         ++expected_height;
+      }
+   };
+
+   // A larger window is recorded in the blockring table, where blocks older than the blockinfo table are found.
+   const uint32_t large_window = 4 * rolling_window_size;
+   BOOST_REQUIRE_EQUAL(success(), setblockwin(large_window));
+   produce_blocks(large_window + 1);
+   check_latest_blocks(large_window);
+   {
+      const uint32_t block_height = control->head_block_num() - 2 * rolling_window_size;
+      auto           record       = get_recorded_block(block_height);
+      BOOST_REQUIRE(record.has_value());
+      BOOST_CHECK_EQUAL(block_height, record->block_height);
+   }
+
+   // Shrinking the window erases the slots beyond it two per block; the remaining slots are overwritten as blocks are
+   // produced.
+   const uint32_t small_window = 2 * rolling_window_size;
+   BOOST_REQUIRE_EQUAL(success(), setblockwin(small_window));
+   produce_blocks(small_window + 1);
+   check_latest_blocks(small_window);
+   BOOST_CHECK(has_blockwindow());
+
+   // Going back to the default window erases the blockring table and then the blockwindow singleton.
+   BOOST_REQUIRE_EQUAL(success(), setblockwin(rolling_window_size));
+   produce_blocks(small_window / 2 + 1);
+   BOOST_CHECK_EQUAL(0u, get_blockring_size());
+   BOOST_CHECK(!has_blockwindow());
+
+   // The blockinfo table keeps its fixed window of the latest blocks whatever the window is.
+   const auto legacy_table = get_blockinfo_table();
+   BOOST_REQUIRE_EQUAL(rolling_window_size, legacy_table.size());
+   BOOST_CHECK(control->head_block_num() <= legacy_table.back().block_height);
+   BOOST_CHECK_EQUAL(legacy_table.back().block_height - rolling_window_size + 1, legacy_table.front().block_height);
 }
 FC_LOG_AND_RETHROW()
 
@@ -318,9 +457,7 @@ try {
    static_assert(5 <= rolling_window_size && rolling_window_size <= 100000);
 
    // Deploy the blockinfo_tester contract.
-   create_account_with_resources(blockinfo_tester_account_name, config::system_account_name,
-                                 core_sym::from_string("10.0000"), false);
-   set_code(blockinfo_tester_account_name, test_contracts::blockinfo_tester_wasm());
+   deploy_blockinfo_tester();
 
    auto latest_block_batch_info = [this](uint32_t batch_start_height_offset,
                                          uint32_t batch_size) -> blockinfo_tester::latest_block_batch_info_result //
@@ -550,4 +687,66 @@ try {
 }
 FC_LOG_AND_RETHROW()
 
+BOOST_FIXTURE_TEST_CASE(blockinfo_checkpoint_tests, block_info_tester)
+try {
+   deploy_blockinfo_tester();
+
+   BOOST_REQUIRE(!get_recorded_block_at_or_before(control->head_block_time()).has_value());
+
+   // Produce past two checkpoints of the finest level, well beyond the rolling window.
+   constexpr uint32_t interval = 120;
+   produce_blocks(1);
+   const uint32_t start_block_height = control->head_block_num();
+   produce_blocks(2 * interval + rolling_window_size);
+
+   const uint32_t checkpoint_height = (start_block_height / interval + 1) * interval;
+   const uint32_t latest_height     = control->head_block_num();
+   BOOST_REQUIRE(checkpoint_height + interval + rolling_window_size <= latest_height);
+
+   auto block_time = [&](uint32_t block_height) {
+      return control->fetch_block_by_number(block_height)->timestamp.to_time_point();
+   };
+
+   // Blocks beyond the rolling window are only found if they are checkpoints.
+   {
+      auto record = get_recorded_block(checkpoint_height);
+      BOOST_REQUIRE(record.has_value());
+      BOOST_CHECK_EQUAL(checkpoint_height, record->block_height);
+      BOOST_CHECK(block_time(checkpoint_height) == record->block_timestamp);
+   }
+   BOOST_CHECK(!get_recorded_block(checkpoint_height + 1).has_value());
+   BOOST_CHECK(!get_recorded_block(start_block_height - 1).has_value());
+   {
+      auto record = get_recorded_block(latest_height - 1);
+      BOOST_REQUIRE(record.has_value());
+      BOOST_CHECK(block_time(latest_height - 1) == record->block_timestamp);
+   }
+
+   // Timestamps within the rolling window resolve to the exact block, older ones to the latest checkpoint before them.
+   {
+      auto record = get_recorded_block_at_or_before(block_time(latest_height - 2));
+      BOOST_REQUIRE(record.has_value());
+      BOOST_CHECK_EQUAL(latest_height - 2, record->block_height);
+   }
+   {
+      auto record = get_recorded_block_at_or_before(block_time(checkpoint_height + interval / 2));
+      BOOST_REQUIRE(record.has_value());
+      BOOST_CHECK_EQUAL(checkpoint_height, record->block_height);
+   }
+   BOOST_CHECK(!get_recorded_block_at_or_before(block_time(start_block_height - 1)).has_value());
+
+   // The latest batch can start at a checkpoint outside of the rolling window.
+   {
+      auto result = get_latest_block_batch_info(blockinfo_tester::get_latest_block_batch_info{
+         .batch_start_height_offset = checkpoint_height,
+         .batch_size                = std::numeric_limits<uint32_t>::max(),
+      });
+      BOOST_REQUIRE(result.first.has_value());
+      BOOST_REQUIRE(!result.first->has_error());
+      BOOST_CHECK_EQUAL(checkpoint_height, result.first->result->batch_start_height);
+      BOOST_CHECK(block_time(checkpoint_height) == result.first->result->batch_start_timestamp);
+   }
+}
+FC_LOG_AND_RETHROW()
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
@@ -483,13 +483,15 @@ public:
    auto get_rexorder_result( const transaction_trace_ptr& trace ) {
       std::vector<std::pair<account_name, asset>> output;
       for ( size_t i = 0; i < trace->action_traces.size(); ++i ) {
-         if ( trace->action_traces[i].act.name == "orderresult"_n ) {
-            fc::datastream<const char*> ds( trace->action_traces[i].act.data.data(),
-                                            trace->action_traces[i].act.data.size() );
-            account_name owner; fc::raw::unpack( ds, owner );
-            asset proceeds; fc::raw::unpack( ds, proceeds );
-            output.emplace_back( owner, proceeds );
+         // TELOS BEGIN
+         if ( trace->action_traces[i].act.name == "fillresult"_n ) {
+            std::vector<std::pair<account_name, asset>> fills;
+            fc::raw::unpack( trace->action_traces[i].act.data.data(),
+                             trace->action_traces[i].act.data.size(),
+                             fills );
+            output.insert( output.end(), fills.begin(), fills.end() );
          }
+         // TELOS END
       }
       return output;
    }
@@ -586,6 +588,22 @@ public:
       return push_action( name(user), "rexexec"_n, mvo()("user", user)("max", max) );
    }
 
+   // cpu loans, net loans and sell orders of the execresult sent by a scheduled rexexec, empty when none was sent
+   std::vector<uint16_t> get_rexexec_result( const account_name& user, uint16_t max ) {
+      auto trace = base_tester::push_action( config::system_account_name, "rexexec"_n, user, mvo()("user", user)("max", max) );
+      for ( const auto& at : trace->action_traces ) {
+         if ( at.act.name == "execresult"_n ) {
+            uint16_t cpu_loans = 0, net_loans = 0, sell_orders = 0;
+            fc::datastream<const char*> ds( at.act.data.data(), at.act.data.size() );
+            fc::raw::unpack( ds, cpu_loans );
+            fc::raw::unpack( ds, net_loans );
+            fc::raw::unpack( ds, sell_orders );
+            return { cpu_loans, net_loans, sell_orders };
+         }
+      }
+      return {};
+   }
+
    action_result consolidate( const account_name& owner ) {
       return push_action( name(owner), "consolidate"_n, mvo()("owner", owner) );
    }
@@ -602,12 +620,12 @@ public:
       return push_action( name(owner), "closerex"_n, mvo()("owner", owner) );
    }
 
+   // TELOS BEGIN
+   // CPU and NET loans share the rexloans table, told apart by their `resource` field
    fc::variant get_last_loan(bool cpu) {
-      vector<char> data;
       const auto& db = control->db();
       namespace chain = eosio::chain;
-      auto table = cpu ? "cpuloan"_n : "netloan"_n;
-      const auto* t_id = db.find<eosio::chain::table_id_object, chain::by_code_scope_table>( boost::make_tuple( config::system_account_name, config::system_account_name, table ) );
+      const auto* t_id = db.find<eosio::chain::table_id_object, chain::by_code_scope_table>( boost::make_tuple( config::system_account_name, config::system_account_name, "rexloans"_n ) );
       if ( !t_id ) {
          return fc::variant();
       }
@@ -615,18 +633,20 @@ public:
       const auto& idx = db.get_index<chain::key_value_index, chain::by_scope_primary>();
 
       auto itr = idx.upper_bound( boost::make_tuple( t_id->id, std::numeric_limits<uint64_t>::max() ));
-      if ( itr == idx.begin() ) {
-         return fc::variant();
-      }
-      --itr;
-      if ( itr->t_id != t_id->id ) {
-         return fc::variant();
+      while ( itr != idx.begin() ) {
+         --itr;
+         if ( itr->t_id != t_id->id ) {
+            break;
+         }
+         vector<char> data( itr->value.begin(), itr->value.end() );
+         fc::variant loan = abi_ser.binary_to_variant( "rex_resource_loan", data, abi_serializer::create_yield_function(abi_serializer_max_time) );
+         if ( ( loan["resource"].as<uint8_t>() == 0 ) == cpu ) {
+            return loan;
+         }
       }
-
-      data.resize( itr->value.size() );
-      memcpy( data.data(), itr->value.data(), data.size() );
-      return data.empty() ? fc::variant() : abi_ser.binary_to_variant( "rex_loan", data, abi_serializer::create_yield_function(abi_serializer_max_time) );
+      return fc::variant();
    }
+   // TELOS END
 
    fc::variant get_last_cpu_loan() {
       return get_last_loan( true );
@@ -637,8 +657,15 @@ public:
    }
 
    fc::variant get_loan_info( const uint64_t& loan_num, bool cpu ) const {
+      // TELOS BEGIN
+      vector<char> data = get_row_by_account( config::system_account_name, config::system_account_name, "rexloans"_n, account_name(loan_num) );
+      if ( !data.empty() ) {
+         fc::variant loan = abi_ser.binary_to_variant( "rex_resource_loan", data, abi_serializer::create_yield_function(abi_serializer_max_time) );
+         return ( loan["resource"].as<uint8_t>() == 0 ) == cpu ? loan : fc::variant();
+      }
+      // TELOS END
       name table_name = cpu ? "cpuloan"_n : "netloan"_n;
-      vector<char> data = get_row_by_account( config::system_account_name, config::system_account_name, table_name, account_name(loan_num) );
+      data = get_row_by_account( config::system_account_name, config::system_account_name, table_name, account_name(loan_num) );
       return data.empty() ? fc::variant() : abi_ser.binary_to_variant( "rex_loan", data, abi_serializer::create_yield_function(abi_serializer_max_time) );
    }
 
@@ -759,6 +786,18 @@ public:
       memcpy( data.data(), itr->value.data(), data.size() );
       return data.empty() ? fc::variant() : abi_ser.binary_to_variant( "rex_return_buckets", data, abi_serializer::create_yield_function(abi_serializer_max_time) );
    }
+
+   // TELOS BEGIN
+   size_t get_rex_return_bucket_count() const {
+      size_t count = 0;
+      for ( const auto& bucket : get_rex_return_buckets()["return_buckets"].get_array() ) {
+         if ( bucket["first"].as<time_point_sec>().sec_since_epoch() != 0 ) {
+            ++count;
+         }
+      }
+      return count;
+   }
+   // TELOS END
       
    void setup_rex_accounts( const std::vector<account_name>& accounts,
                             const asset& init_balance,
@@ -1089,6 +1128,79 @@ public:
       vector<char> data = get_row_by_account( config::system_account_name, config::system_account_name, "payments"_n, account );
       return data.empty() ? fc::variant() : abi_ser.binary_to_variant( "payment_info", data, abi_serializer::create_yield_function(abi_serializer_max_time) );
    }
+
+   fc::variant get_vote_repair_state() {
+      vector<char> data = get_row_by_account( config::system_account_name, config::system_account_name, "voterepair"_n, "voterepair"_n );
+      return data.empty() ? fc::variant() : abi_ser.binary_to_variant( "vote_repair_state", data, abi_serializer::create_yield_function(abi_serializer_max_time) );
+   }
+
+   // Rewrites a row on both nodes outside of any transaction, to seed states that actions cannot reach. The row must
+   // exist unless `create` is set, created rows are not billed to anyone.
+   // The pending block is dropped first, so both nodes build the next block on the edited head state.
+   void set_row_by_account( const account_name& code, const account_name& scope, const table_name& table, const account_name& act, const vector<char>& data, bool create = false ) {
+      control->abort_block();
+      std::vector<controller*> chains = { control.get() };
+#ifndef NON_VALIDATING_TEST
+      chains.push_back( validating_node.get() );
+#endif
+      for( auto* chain : chains ) {
+         auto& db = chain->mutable_db();
+         const auto* t_id = db.find<table_id_object, by_code_scope_table>( boost::make_tuple( code, scope, table ) );
+         if( t_id == nullptr && create ) {
+            t_id = &db.create<table_id_object>( [&]( table_id_object& t ) {
+               t.code  = code;
+               t.scope = scope;
+               t.table = table;
+               t.payer = code;
+            });
+         }
+         BOOST_REQUIRE( t_id != nullptr );
+         const auto* obj = db.find<key_value_object, by_scope_primary>( boost::make_tuple( t_id->id, act.to_uint64_t() ) );
+         if( obj == nullptr && create ) {
+            db.create<key_value_object>( [&]( key_value_object& kv ) {
+               kv.t_id        = t_id->id;
+               kv.primary_key = act.to_uint64_t();
+               kv.payer       = code;
+               kv.value.assign( data.data(), data.size() );
+            });
+            db.modify( *t_id, []( table_id_object& t ) { ++t.count; });
+            continue;
+         }
+         BOOST_REQUIRE( obj != nullptr );
+         db.modify( *obj, [&]( key_value_object& kv ) {
+            kv.value.assign( data.data(), data.size() );
+         });
+      }
+   }
+
+   void edit_global_state( const std::function<void(mvo&)>& edit ) {
+      control->abort_block();
+      mvo gs( get_global_state().get_object() );
+      edit( gs );
+      set_row_by_account( config::system_account_name, config::system_account_name, "global"_n, "global"_n,
+                          abi_ser.variant_to_binary( "eosio_global_state", gs, abi_serializer::create_yield_function(abi_serializer_max_time) ) );
+   }
+
+   // Writes the eosio.tedp payout row of `to`, the tester does not deploy the TEDP contract
+   void set_tedp_payout( const account_name& to, uint64_t amount, uint64_t interval, uint64_t last_payout ) {
+      vector<char> data( 4 * sizeof(uint64_t) );
+      fc::datastream<char*> ds( data.data(), data.size() );
+      fc::raw::pack( ds, to );
+      fc::raw::pack( ds, amount );
+      fc::raw::pack( ds, interval );
+      fc::raw::pack( ds, last_payout );
+      set_row_by_account( "exrsrv.tf"_n, "exrsrv.tf"_n, "payouts"_n, to, data, true );
+   }
+
+   fc::variant paypreview( const account_name& caller ) {
+      auto trace = base_tester::push_action( config::system_account_name, "paypreview"_n, caller, mvo() );
+      return abi_ser.binary_to_variant( "tedp_pay_flows", trace->action_traces[0].return_value, abi_serializer::create_yield_function(abi_serializer_max_time) );
+   }
+
+   fc::variant get_delegated_total( const account_name& owner ) {
+      vector<char> data = get_row_by_account( config::system_account_name, config::system_account_name, "delegatedtot"_n, owner );
+      return data.empty() ? fc::variant() : abi_ser.binary_to_variant( "delegated_total", data, abi_serializer::create_yield_function(abi_serializer_max_time) );
+   }
    // END TELOS ADDITIONS
 
    fc::variant get_refund_request( name account ) {
@@ -5717,7 +5717,8 @@ BOOST_FIXTURE_TEST_CASE( rex_return, eosio_system_tester ) try {
       auto rex_return_pool = get_rex_return_pool();
       BOOST_REQUIRE_EQUAL( false,            rex_return_pool.is_null() );
       BOOST_REQUIRE_EQUAL( 0,                rex_return_pool["current_rate_of_increase"].as<int64_t>() );
-      BOOST_REQUIRE_EQUAL( 0,                get_rex_return_buckets()["return_buckets"].get_array().size() );
+      BOOST_REQUIRE_EQUAL( 0,                get_rex_return_bucket_count() );
+      BOOST_REQUIRE_EQUAL( 60,               get_rex_return_buckets()["return_buckets"].get_array().size() );
       BOOST_REQUIRE_EQUAL( expected_pending_bucket_time.sec_since_epoch(),
                            rex_return_pool["pending_bucket_time"].as<time_point_sec>().sec_since_epoch() );
       int32_t t0 = rex_return_pool["pending_bucket_time"].as<time_point_sec>().sec_since_epoch();
@@ -5740,7 +5741,7 @@ BOOST_FIXTURE_TEST_CASE( rex_return, eosio_system_tester ) try {
       BOOST_REQUIRE_EQUAL( success(),        rexexec( bob, 1 ) );
       rex_return_pool = get_rex_return_pool();
       BOOST_REQUIRE_EQUAL( rate,             rex_return_pool["current_rate_of_increase"].as<int64_t>() );
-      BOOST_REQUIRE_EQUAL( 1,                get_rex_return_buckets()["return_buckets"].get_array().size() );
+      BOOST_REQUIRE_EQUAL( 1,                get_rex_return_bucket_count() );
       int64_t t2 = rex_return_pool["last_dist_time"].as<time_point_sec>().sec_since_epoch();
       change      = rate * ((t2-t0) / dist_interval) + fee.get_amount() % total_intervals;
       expected    = payment.get_amount() + change;
@@ -5754,7 +5755,7 @@ BOOST_FIXTURE_TEST_CASE( rex_return, eosio_system_tester ) try {
 
       rex_return_pool = get_rex_return_pool();
       BOOST_REQUIRE_EQUAL( 0,                rex_return_pool["current_rate_of_increase"].as<int64_t>() );
-      BOOST_REQUIRE_EQUAL( 0,                get_rex_return_buckets()["return_buckets"].get_array().size() );
+      BOOST_REQUIRE_EQUAL( 0,                get_rex_return_bucket_count() );
 
       rex_pool = get_rex_pool();
       expected = payment.get_amount() + fee.get_amount();
@@ -5775,14 +5776,14 @@ BOOST_FIXTURE_TEST_CASE( rex_return, eosio_system_tester ) try {
       BOOST_REQUIRE_EQUAL( success(),        rentnet( bob, bob, fee ) );
       rex_return_pool = get_rex_return_pool();
       BOOST_REQUIRE_EQUAL( 0,                rex_return_pool["current_rate_of_increase"].as<int64_t>() );
-      BOOST_REQUIRE_EQUAL( 0,                get_rex_return_buckets()["return_buckets"].get_array().size() );
+      BOOST_REQUIRE_EQUAL( 0,                get_rex_return_bucket_count() );
       uint32_t t1 = rex_return_pool["last_dist_time"].as<time_point_sec>().sec_since_epoch();
       BOOST_REQUIRE_EQUAL( t1,               t0 + 6 * dist_interval );
 
       produce_block( fc::hours(12) );
       BOOST_REQUIRE_EQUAL( success(),        rentnet( bob, bob, fee ) );
       rex_return_pool = get_rex_return_pool();
-      BOOST_REQUIRE_EQUAL( 1,                get_rex_return_buckets()["return_buckets"].get_array().size() );
+      BOOST_REQUIRE_EQUAL( 1,                get_rex_return_bucket_count() );
       int64_t rate = 2 * fee.get_amount() / total_intervals;
       BOOST_REQUIRE_EQUAL( rate,             rex_return_pool["current_rate_of_increase"].as<int64_t>() );
       produce_block( fc::hours(8) );
@@ -5800,7 +5801,7 @@ BOOST_FIXTURE_TEST_CASE( rex_return, eosio_system_tester ) try {
       BOOST_REQUIRE_EQUAL( success(),        rexexec( bob, 1 ) );
       rex_return_pool = get_rex_return_pool();
       BOOST_REQUIRE_EQUAL( 0,                rex_return_pool["current_rate_of_increase"].as<int64_t>() );
-      BOOST_REQUIRE_EQUAL( 0,                get_rex_return_buckets()["return_buckets"].get_array().size() );
+      BOOST_REQUIRE_EQUAL( 0,                get_rex_return_bucket_count() );
       BOOST_REQUIRE_EQUAL( init_lendable.get_amount() + 3 * fee.get_amount(),
                            get_rex_pool()["total_lendable"].as<asset>().get_amount() );
    }
@@ -5831,7 +5832,7 @@ BOOST_FIXTURE_TEST_CASE( rex_return, eosio_system_tester ) try {
       produce_block( fc::days(31) );
       produce_blocks( 1 );
       BOOST_REQUIRE_EQUAL( success(),        rexexec( bob, 1 ) );
-      BOOST_REQUIRE_EQUAL( 0,                get_rex_return_buckets()["return_buckets"].get_array().size() );
+      BOOST_REQUIRE_EQUAL( 0,                get_rex_return_bucket_count() );
       BOOST_REQUIRE_EQUAL( 0,                get_rex_return_pool()["current_rate_of_increase"].as<int64_t>() );
    }
 
@@ -5842,10 +5843,11 @@ BOOST_FIXTURE_TEST_CASE( rex_return, eosio_system_tester ) try {
          produce_block( fc::days(1) );
       }
       BOOST_REQUIRE_EQUAL( success(),        rexexec( bob, 1 ) );
-      BOOST_REQUIRE_EQUAL( 5,                get_rex_return_buckets()["return_buckets"].get_array().size() );
+      BOOST_REQUIRE_EQUAL( 5,                get_rex_return_bucket_count() );
+      BOOST_REQUIRE_EQUAL( 60,               get_rex_return_buckets()["return_buckets"].get_array().size() );
       produce_block( fc::days(30) );
       BOOST_REQUIRE_EQUAL( success(),        rexexec( bob, 1 ) );
-      BOOST_REQUIRE_EQUAL( 0,                get_rex_return_buckets()["return_buckets"].get_array().size() );
+      BOOST_REQUIRE_EQUAL( 0,                get_rex_return_bucket_count() );
    }
 
 } FC_LOG_AND_RETHROW()
@@ -1,6 +1,11 @@
 #include <boost/test/unit_test.hpp>
 
+#include <cmath>
+#include <cstring>
+#include <set>
+
 #include "eosio.system_tester.hpp"
+#include "../contracts/eosio.system/include/eosio.system/vote_weight.hpp"
 
 #define MAX_PRODUCERS 42
 
@@ -330,7 +335,8 @@ BOOST_FIXTURE_TEST_CASE(multi_producer_pay, eosio_system_tester, * boost::unit_t
       for(const name &p : producer_names)
          producer_infos.emplace_back(get_producer_info(p));
 
-      std::sort(producer_infos.begin(), producer_infos.end(), comparator);
+      // producers with equal votes keep their name order, the order in which onblock credits them
+      std::stable_sort(producer_infos.begin(), producer_infos.end(), comparator);
       BOOST_REQUIRE_EQUAL(get_balance("eosio.bpay"_n), initial_bpay_balance + to_bpay);
 
       for(const fc::variant &prod_info : producer_infos) {
@@ -387,4 +393,623 @@ BOOST_FIXTURE_TEST_CASE(multi_producer_pay, eosio_system_tester, * boost::unit_t
    }
 } FC_LOG_AND_RETHROW()
 
+BOOST_FIXTURE_TEST_CASE(multi_producer_pay_settles_in_onblock, eosio_system_tester) try {
+   const int producer_amount = MAX_PRODUCERS;
+
+   std::vector<account_name> producer_names;
+   for(uint8_t i = 0; i < producer_amount; i++)
+      producer_names.emplace_back(name(std::string("tprod") + toBase31(i)));
+   setup_producer_accounts(producer_names);
+   for ( const auto& p: producer_names )
+      BOOST_REQUIRE_EQUAL( success(), regproducer(p) );
+   std::sort(producer_names.begin(), producer_names.end());
+
+   const asset large_asset = core_sym::from_string("80.0000");
+   create_account_with_resources( "producvotera"_n, config::system_account_name, core_sym::from_string("1.0000"), false, large_asset, large_asset );
+   create_account_with_resources( "producvoterb"_n, config::system_account_name, core_sym::from_string("1.0000"), false, large_asset, large_asset );
+   transfer(config::system_account_name, "producvotera", core_sym::from_string("400000000.0000"), config::system_account_name);
+   BOOST_REQUIRE_EQUAL(success(), stake("producvotera", core_sym::from_string("150000000.0000"), core_sym::from_string("150000000.0000")));
+   transfer(config::system_account_name, "producvoterb", core_sym::from_string("400000000.0000"), config::system_account_name);
+   BOOST_REQUIRE_EQUAL(success(), stake("producvoterb", core_sym::from_string("100000000.0000"), core_sym::from_string("100000000.0000")));
+   BOOST_REQUIRE_EQUAL(success(), vote( "producvotera"_n, vector<name>( producer_names.begin(), producer_names.begin() + 21 )));
+   BOOST_REQUIRE_EQUAL(success(), vote( "producvoterb"_n, vector<name>( producer_names.begin() + 21, producer_names.end() )));
+
+   produce_blocks((1000 - get_global_state()["block_num"].as<uint32_t>()) + 1);
+
+   // produce up to the block that closes the pay period
+   const uint32_t last_claim_time = get_global_state()["last_claimrewards"].as<uint32_t>();
+   for (uint32_t n = 0; n < 3600 + 2 && last_claim_time == get_global_state()["last_claimrewards"].as<uint32_t>(); ++n)
+      produce_block();
+   BOOST_REQUIRE(last_claim_time < get_global_state()["last_claimrewards"].as<uint32_t>());
+
+   // every producer of the period was paid for its blocks when the period closed
+   BOOST_REQUIRE_EQUAL(0, get_global_state()["total_unpaid_blocks"].as<uint32_t>());
+   for ( const auto& p: producer_names )
+      BOOST_REQUIRE_EQUAL(0, get_producer_info(p)["unpaid_blocks"].as<uint32_t>());
+
+   // onblock alone credits every payments row, a few producers per block
+   const uint32_t settle_blocks = (producer_amount + 6) / 7;
+   produce_blocks(settle_blocks);
+   BOOST_REQUIRE_EQUAL(wasm_assert_msg("no producer pay to settle"),
+                       push_action(config::system_account_name, "settlepay"_n, mvo()("max", 1)));
+
+   std::set<int64_t> pays;
+   for ( const auto& p: producer_names ) {
+      const fc::variant payment = get_payment_info(p);
+      BOOST_REQUIRE(!payment.is_null());
+      BOOST_REQUIRE(payment["pay"].as<asset>().get_amount() > 0);
+      pays.insert(payment["pay"].as<asset>().get_amount());
+   }
+   // the top producers earn two shares, the standbys one
+   BOOST_REQUIRE_EQUAL(2, pays.size());
+   BOOST_REQUIRE_EQUAL(*pays.rbegin(), 2 * *pays.begin());
+
+   // the blocks produced while the period was being settled are kept for the next one
+   BOOST_REQUIRE_EQUAL(settle_blocks, get_global_state()["total_unpaid_blocks"].as<uint32_t>());
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(repairvotes_requires_running_repair, eosio_system_tester) try {
+   create_account_with_resources( "producvotera"_n, config::system_account_name, core_sym::from_string("1.0000"), false );
+
+   // no drift, so onblock never starts a recount
+   produce_blocks(10);
+   const fc::variant repair_state = get_vote_repair_state();
+   BOOST_REQUIRE(repair_state.is_null() || repair_state["stage"].as<uint8_t>() == 0);
+
+   BOOST_REQUIRE_EQUAL(wasm_assert_msg("no vote repair in progress"),
+                       push_action("producvotera"_n, "repairvotes"_n, mvo()("max", 10)));
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(vote_repair_recounts_incrementally, eosio_system_tester, * boost::unit_test::tolerance(1e-5)) try {
+   const auto producer_names = active_and_vote_producers();
+
+   // standby producers, so a producer removed during the repair has someone to hand its seat to
+   setup_producer_accounts({ "defproducerv"_n, "defproducerw"_n });
+   BOOST_REQUIRE_EQUAL( success(), regproducer( "defproducerv"_n ) );
+   BOOST_REQUIRE_EQUAL( success(), regproducer( "defproducerw"_n ) );
+
+   // enough voters that the recount spans several onblocks
+   std::vector<account_name> voters;
+   for( uint8_t i = 0; i < 150; ++i ) {
+      voters.emplace_back( "tvote" + toBase31(i) );
+   }
+   std::sort( voters.begin(), voters.end() );
+   for( size_t i = 0; i < voters.size(); ++i ) {
+      create_account_with_resources( voters[i], config::system_account_name, core_sym::from_string("1.0000"), false );
+      transfer( config::system_account_name, voters[i], core_sym::from_string("100.0000"), config::system_account_name );
+      BOOST_REQUIRE_EQUAL( success(), stake( voters[i], core_sym::from_string("40.0000"), core_sym::from_string("40.0000") ) );
+      BOOST_REQUIRE_EQUAL( success(), vote( voters[i], { producer_names[i % producer_names.size()], "defproducerv"_n, "defproducerw"_n } ) );
+   }
+
+   // the tallies before the drift are what a full recount has to arrive at
+   std::vector<account_name> all_producers = producer_names;
+   all_producers.push_back( "defproducerv"_n );
+   all_producers.push_back( "defproducerw"_n );
+   std::map<account_name, double> expected_votes;
+   for( const auto& p : all_producers ) {
+      expected_votes[p] = get_producer_info( p )["total_votes"].as<double>();
+   }
+   const double  expected_weight    = get_global_state()["total_producer_vote_weight"].as<double>();
+   const int64_t expected_activated = get_global_state()["total_activated_stake"].as<int64_t>();
+
+   edit_global_state( []( mvo& gs ) { gs["total_producer_vote_weight"] = -1.0; } );
+   produce_block();
+
+   fc::variant state = get_vote_repair_state();
+   BOOST_REQUIRE_NE( 0, state["stage"].as<uint8_t>() );
+
+   // a voter the recount has not reached keeps its selection out of the tallies
+   BOOST_REQUIRE( state["stage"].as<uint8_t>() < 3 || state["cursor"].as<account_name>() <= voters.back() );
+   BOOST_REQUIRE_EQUAL( success(), vote( voters.back(), { producer_names[(voters.size() - 1) % producer_names.size()], "defproducerv"_n, "defproducerw"_n } ) );
+   BOOST_REQUIRE_EQUAL( 0, get_voter_info( voters.back() )["last_vote_weight"].as<double>() );
+
+   // a producer removed during the repair still leaves the schedule, alice's recount keeps its votes
+   BOOST_REQUIRE_EQUAL( success(), push_action( "defproducerb"_n, "unregprod"_n, mvo()("producer", "defproducerb") ) );
+   edit_global_state( []( mvo& gs ) { gs["last_producer_schedule_update"] = fc::variant( block_timestamp_type() ); } );
+   produce_block();
+   BOOST_REQUIRE_NE( 0, get_vote_repair_state()["stage"].as<uint8_t>() );
+   const auto metrics = get_gmetrics_state()["producers_metric"].get_array();
+   BOOST_REQUIRE_EQUAL( 21, metrics.size() );
+   for( const auto& pm : metrics ) {
+      BOOST_REQUIRE( pm["bp_name"].as<account_name>() != "defproducerb"_n );
+   }
+
+   // repairvotes only ever moves the recount forward, and a counted voter votes against the live tallies
+   bool revoted_counted = false;
+   state = get_vote_repair_state();
+   while( state["stage"].as<uint8_t>() != 0 ) {
+      BOOST_REQUIRE_EQUAL( success(), push_action( "alice1111111"_n, "repairvotes"_n, mvo()("max", 10) ) );
+      const fc::variant next = get_vote_repair_state();
+      const auto stage      = state["stage"].as<uint8_t>();
+      const auto next_stage = next["stage"].as<uint8_t>();
+      BOOST_REQUIRE( next_stage == 0 || next_stage > stage ||
+                     ( next_stage == stage && next["cursor"].as<account_name>() > state["cursor"].as<account_name>() ) );
+
+      if( !revoted_counted && next_stage == 3 && voters.front() < next["cursor"].as<account_name>() ) {
+         const double weight = get_voter_info( voters.front() )["last_vote_weight"].as<double>();
+         BOOST_REQUIRE( weight > 0 );
+         BOOST_REQUIRE_EQUAL( success(), vote( voters.front(), { producer_names[0], "defproducerv"_n, "defproducerw"_n } ) );
+         BOOST_TEST( weight == get_voter_info( voters.front() )["last_vote_weight"].as<double>() );
+         revoted_counted = true;
+      }
+      state = get_vote_repair_state();
+   }
+   BOOST_REQUIRE( revoted_counted );
+
+   for( const auto& p : all_producers ) {
+      BOOST_TEST( expected_votes[p] == get_producer_info( p )["total_votes"].as<double>() );
+   }
+   BOOST_TEST( expected_weight == get_global_state()["total_producer_vote_weight"].as<double>() );
+   BOOST_REQUIRE_EQUAL( expected_activated, get_global_state()["total_activated_stake"].as<int64_t>() );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("no vote repair in progress"),
+                        push_action( "alice1111111"_n, "repairvotes"_n, mvo()("max", 10) ) );
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(auto_payout_transfers_pay_on_settlement, eosio_system_tester) try {
+   const asset large_asset = core_sym::from_string("80.0000");
+   create_account_with_resources( "defproducera"_n, config::system_account_name, core_sym::from_string("1.0000"), false, large_asset, large_asset );
+   create_account_with_resources( "producvotera"_n, config::system_account_name, core_sym::from_string("1.0000"), false, large_asset, large_asset );
+
+   BOOST_REQUIRE_EQUAL(wasm_assert_msg("producer not found"),
+                       push_action("defproducera"_n, "setautopay"_n, mvo()("producer", "defproducera")("enabled", true)));
+   BOOST_REQUIRE_EQUAL(success(), regproducer("defproducera"_n));
+   BOOST_REQUIRE_EQUAL(wasm_assert_msg("auto payout is not enabled"),
+                       push_action("defproducera"_n, "setautopay"_n, mvo()("producer", "defproducera")("enabled", false)));
+   BOOST_REQUIRE_EQUAL(success(),
+                       push_action("defproducera"_n, "setautopay"_n, mvo()("producer", "defproducera")("enabled", true)));
+   BOOST_REQUIRE_EQUAL(wasm_assert_msg("auto payout is already enabled"),
+                       push_action("defproducera"_n, "setautopay"_n, mvo()("producer", "defproducera")("enabled", true)));
+
+   transfer(config::system_account_name, "producvotera", core_sym::from_string("400000000.0000"), config::system_account_name);
+   BOOST_REQUIRE_EQUAL(success(), stake("producvotera", core_sym::from_string("100000000.0000"), core_sym::from_string("100000000.0000")));
+   BOOST_REQUIRE_EQUAL(success(), vote( "producvotera"_n, { "defproducera"_n }));
+
+   produce_blocks((1000 - get_global_state()["block_num"].as<uint32_t>()) + 1);
+   transfer(name("eosio"), name("exrsrv.tf"), core_sym::from_string("400000000.0000"), config::system_account_name);
+
+   const asset initial_balance = get_balance("defproducera"_n);
+   const uint32_t last_claim_time = get_global_state()["last_claimrewards"].as<uint32_t>();
+   for (uint32_t n = 0; n < 3600 + 2 && last_claim_time == get_global_state()["last_claimrewards"].as<uint32_t>(); ++n)
+      produce_block();
+   BOOST_REQUIRE(last_claim_time < get_global_state()["last_claimrewards"].as<uint32_t>());
+
+   // the pay was transferred while the period was settled, nothing is left to claim
+   BOOST_REQUIRE(get_payment_info("defproducera"_n).is_null());
+   const asset paid = get_balance("defproducera"_n) - initial_balance;
+   BOOST_REQUIRE(paid.get_amount() > 0);
+   BOOST_REQUIRE_EQUAL(0, get_producer_info("defproducera")["unpaid_blocks"].as<uint32_t>());
+   BOOST_REQUIRE_EQUAL(wasm_assert_msg("No payment exists for account"),
+                       push_action("defproducera"_n, "claimrewards"_n, mvo()("owner", "defproducera")));
+
+   // once disabled, pay waits in the payments table again
+   BOOST_REQUIRE_EQUAL(success(),
+                       push_action("defproducera"_n, "setautopay"_n, mvo()("producer", "defproducera")("enabled", false)));
+   produce_blocks(3600 + 2);
+   BOOST_REQUIRE(!get_payment_info("defproducera"_n).is_null());
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(auto_payout_skips_zero_pay, eosio_system_tester) try {
+   const asset large_asset = core_sym::from_string("80.0000");
+   create_account_with_resources( "defproducera"_n, config::system_account_name, core_sym::from_string("1.0000"), false, large_asset, large_asset );
+   create_account_with_resources( "producvotera"_n, config::system_account_name, core_sym::from_string("1.0000"), false, large_asset, large_asset );
+
+   BOOST_REQUIRE_EQUAL(success(), regproducer("defproducera"_n));
+   BOOST_REQUIRE_EQUAL(success(),
+                       push_action("defproducera"_n, "setautopay"_n, mvo()("producer", "defproducera")("enabled", true)));
+
+   transfer(config::system_account_name, "producvotera", core_sym::from_string("400000000.0000"), config::system_account_name);
+   BOOST_REQUIRE_EQUAL(success(), stake("producvotera", core_sym::from_string("100000000.0000"), core_sym::from_string("100000000.0000")));
+   BOOST_REQUIRE_EQUAL(success(), vote( "producvotera"_n, { "defproducera"_n }));
+
+   produce_blocks((1000 - get_global_state()["block_num"].as<uint32_t>()) + 1);
+   transfer(name("eosio"), name("exrsrv.tf"), core_sym::from_string("400000000.0000"), config::system_account_name);
+
+   // an empty per-block bucket that is never filled again makes every share of the period worth nothing
+   edit_global_state( []( mvo& gs ) {
+      gs["perblock_bucket"] = 0;
+      gs["last_pervote_bucket_fill"] = fc::time_point::from_iso_string( "2100-01-01T00:00:00.000" );
+   } );
+
+   const asset initial_balance = get_balance("defproducera"_n);
+   const uint32_t last_claim_time = get_global_state()["last_claimrewards"].as<uint32_t>();
+   for (uint32_t n = 0; n < 3600 + 2 && last_claim_time == get_global_state()["last_claimrewards"].as<uint32_t>(); ++n)
+      produce_block();
+
+   // the settlement skipped the empty transfer instead of failing onblock, which would have undone the snapshot
+   BOOST_REQUIRE(last_claim_time < get_global_state()["last_claimrewards"].as<uint32_t>());
+   BOOST_REQUIRE_EQUAL(0, get_producer_info("defproducera")["unpaid_blocks"].as<uint32_t>());
+   BOOST_REQUIRE(get_payment_info("defproducera"_n).is_null());
+   BOOST_REQUIRE_EQUAL(initial_balance, get_balance("defproducera"_n));
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(pay_requires_due_payouts, eosio_system_tester) try {
+   create_account_with_resources( "tedpcranker1"_n, config::system_account_name, core_sym::from_string("1.0000"), false );
+
+   // no TEDP payouts are configured, so there is nothing to pay and nothing is issued
+   const asset initial_supply = get_token_supply();
+   BOOST_REQUIRE_EQUAL(wasm_assert_msg("No payouts are due"),
+                       push_action("tedpcranker1"_n, "pay"_n, mvo()));
+   produce_blocks(1);
+   BOOST_REQUIRE_EQUAL(initial_supply, get_token_supply());
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(paypreview_matches_pay, eosio_system_tester) try {
+   create_account_with_resources( "tedpcranker1"_n, config::system_account_name, core_sym::from_string("1.0000"), false );
+   const uint64_t interval = 3600;
+   auto now = [&]() { return uint64_t(control->head_block_time().sec_since_epoch()); };
+
+   // two intervals of a 5 TLOS payout are due, REX is configured but has no amount yet
+   set_tedp_payout( "ignitegrants"_n, 5, interval, now() - 2 * interval - 10 );
+   set_tedp_payout( "eosio.rex"_n, 0, interval, now() - 2 * interval - 10 );
+   produce_block();
+
+   // the preview neither writes nor bills anything
+   const int64_t ram_usage = control->get_resource_limits_manager().get_account_ram_usage( config::system_account_name );
+   fc::variant preview = paypreview( "tedpcranker1"_n );
+   BOOST_REQUIRE_EQUAL( ram_usage, control->get_resource_limits_manager().get_account_ram_usage( config::system_account_name ) );
+   BOOST_REQUIRE_EQUAL( core_sym::from_string("10.0000"), preview["payout"].as<asset>() );
+   BOOST_REQUIRE_EQUAL( 1, preview["due"].get_array().size() );
+   BOOST_REQUIRE_EQUAL( "ignitegrants", preview["due"].get_array()[0].as_string() );
+
+   // pay issues exactly what the preview reported to the TEDP account
+   asset initial_supply = get_token_supply();
+   asset initial_tedp_balance = get_balance( "exrsrv.tf"_n );
+   BOOST_REQUIRE_EQUAL( success(), push_action( "tedpcranker1"_n, "pay"_n, mvo() ) );
+   BOOST_REQUIRE_EQUAL( initial_supply + preview["issue"].as<asset>(), get_token_supply() );
+   BOOST_REQUIRE_EQUAL( initial_tedp_balance + preview["issue"].as<asset>(), get_balance( "exrsrv.tf"_n ) );
+
+   // TEDP records its own payouts, nothing is due until the next interval
+   set_tedp_payout( "ignitegrants"_n, 5, interval, now() );
+   preview = paypreview( "tedpcranker1"_n );
+   BOOST_REQUIRE( preview["due"].get_array().empty() );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("No payouts are due"), push_action( "tedpcranker1"_n, "pay"_n, mvo() ) );
+
+   // a payout whose amount changes from 0 is due right away, without waiting for the other payout
+   set_tedp_payout( "eosio.rex"_n, 3, interval, now() - interval - 10 );
+   produce_block();
+   preview = paypreview( "tedpcranker1"_n );
+   BOOST_REQUIRE_EQUAL( 1, preview["due"].get_array().size() );
+   BOOST_REQUIRE_EQUAL( "eosio.rex", preview["due"].get_array()[0].as_string() );
+   // no oracle price is available, so the REX payout is not reduced
+   BOOST_REQUIRE_EQUAL( core_sym::from_string("3.0000"), preview["payout"].as<asset>() );
+
+   initial_supply = get_token_supply();
+   initial_tedp_balance = get_balance( "exrsrv.tf"_n );
+   BOOST_REQUIRE_EQUAL( success(), push_action( "tedpcranker1"_n, "pay"_n, mvo() ) );
+   BOOST_REQUIRE_EQUAL( initial_supply + preview["issue"].as<asset>(), get_token_supply() );
+   BOOST_REQUIRE_EQUAL( initial_tedp_balance + preview["issue"].as<asset>(), get_balance( "exrsrv.tf"_n ) );
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(delegated_total_tracks_delband, eosio_system_tester) try {
+   create_account_with_resources( "producvoterb"_n, config::system_account_name, core_sym::from_string("1.0000"), false );
+   transfer( config::system_account_name, "producvoterb"_n, core_sym::from_string("100.0000") );
+
+   // first delegation creates a reconciled total
+   BOOST_REQUIRE_EQUAL( success(), stake( "producvoterb"_n, "producvoterb"_n, core_sym::from_string("10.0000"), core_sym::from_string("10.0000") ) );
+   fc::variant total = get_delegated_total( "producvoterb"_n );
+   BOOST_REQUIRE_EQUAL( true, total["reconciled"].as<bool>() );
+   BOOST_REQUIRE_EQUAL( 200000, total["delegated"].as<int64_t>() );
+
+   BOOST_REQUIRE_EQUAL( success(), stake( "producvoterb"_n, "alice1111111"_n, core_sym::from_string("5.0000"), core_sym::from_string("5.0000") ) );
+   BOOST_REQUIRE_EQUAL( 300000, get_delegated_total( "producvoterb"_n )["delegated"].as<int64_t>() );
+
+   BOOST_REQUIRE_EQUAL( success(), push_action( "producvoterb"_n, "undelegatebw"_n, mvo()
+                                                ("from", "producvoterb")
+                                                ("receiver", "alice1111111")
+                                                ("unstake_net_quantity", core_sym::from_string("5.0000"))
+                                                ("unstake_cpu_quantity", core_sym::from_string("2.0000")) ) );
+   BOOST_REQUIRE_EQUAL( 230000, get_delegated_total( "producvoterb"_n )["delegated"].as<int64_t>() );
+
+   BOOST_REQUIRE_EQUAL( error("missing authority of eosio"),
+                        push_action( "producvoterb"_n, "reconcilebw"_n, mvo()("owner", "producvoterb")("max", 10) ) );
+
+   // a verification pass over two delegations, one per call, lands on the same total
+   BOOST_REQUIRE_EQUAL( success(), push_action( config::system_account_name, "reconcilebw"_n, mvo()("owner", "producvoterb")("max", 1) ) );
+   total = get_delegated_total( "producvoterb"_n );
+   BOOST_REQUIRE_EQUAL( false, total["reconciled"].as<bool>() );
+
+   // a delegation the cursor has not reached yet is left for reconcilebw to sum
+   BOOST_REQUIRE_EQUAL( success(), stake( "producvoterb"_n, "producvoterb"_n, core_sym::from_string("1.0000"), core_sym::from_string("1.0000") ) );
+
+   BOOST_REQUIRE_EQUAL( success(), push_action( config::system_account_name, "reconcilebw"_n, mvo()("owner", "producvoterb")("max", 1) ) );
+   total = get_delegated_total( "producvoterb"_n );
+   BOOST_REQUIRE_EQUAL( true, total["reconciled"].as<bool>() );
+   BOOST_REQUIRE_EQUAL( 250000, total["delegated"].as<int64_t>() );
+
+   // removing every delegation erases the total, and the delegator pays for it when it comes back
+   BOOST_REQUIRE_EQUAL( success(), push_action( "producvoterb"_n, "undelegatebw"_n, mvo()
+                                                ("from", "producvoterb")
+                                                ("receiver", "alice1111111")
+                                                ("unstake_net_quantity", core_sym::from_string("0.0000"))
+                                                ("unstake_cpu_quantity", core_sym::from_string("3.0000")) ) );
+   BOOST_REQUIRE_EQUAL( success(), push_action( "producvoterb"_n, "undelegatebw"_n, mvo()
+                                                ("from", "producvoterb")
+                                                ("receiver", "producvoterb")
+                                                ("unstake_net_quantity", core_sym::from_string("11.0000"))
+                                                ("unstake_cpu_quantity", core_sym::from_string("11.0000")) ) );
+   BOOST_REQUIRE( get_delegated_total( "producvoterb"_n ).is_null() );
+
+   const auto& rlm = control->get_resource_limits_manager();
+   const auto system_ram_usage = rlm.get_account_ram_usage( config::system_account_name );
+   BOOST_REQUIRE_EQUAL( success(), stake( "producvoterb"_n, "alice1111111"_n, core_sym::from_string("1.0000"), core_sym::from_string("1.0000") ) );
+   BOOST_REQUIRE_EQUAL( 20000, get_delegated_total( "producvoterb"_n )["delegated"].as<int64_t>() );
+   BOOST_REQUIRE_EQUAL( system_ram_usage, rlm.get_account_ram_usage( config::system_account_name ) );
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(voteupdates_batch, eosio_system_tester, * boost::unit_test::tolerance(1e-5)) try {
+   const std::vector<account_name> accounts = { "aliceaccount"_n, "bobbyaccount"_n };
+   setup_rex_accounts( accounts, core_sym::from_string("1000.0000") );
+   create_account_with_resources( "defproducera"_n, config::system_account_name, core_sym::from_string("1.0000"), false );
+   BOOST_REQUIRE_EQUAL( success(), regproducer("defproducera"_n) );
+
+   for( const auto& acct : accounts ) {
+      BOOST_REQUIRE_EQUAL( success(), vote( acct, { "defproducera"_n } ) );
+      BOOST_REQUIRE_EQUAL( success(), buyrex( acct, core_sym::from_string("500.0000") ) );
+   }
+
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("voters cannot be empty"),
+                        push_action( "aliceaccount"_n, "voteupdates"_n, mvo()("voters", std::vector<name>{}) ) );
+   BOOST_REQUIRE_EQUAL( error("missing authority of bobbyaccount"),
+                        push_action( "aliceaccount"_n, "voteupdates"_n, mvo()("voters", accounts) ) );
+
+   base_tester::push_action( config::system_account_name, "voteupdates"_n, accounts, mvo()("voters", accounts) );
+   produce_block();
+
+   double expected_votes = 0;
+   for( const auto& acct : accounts ) {
+      const fc::variant voter = get_voter_info( acct );
+      const auto delband = get_dbw_obj( acct, acct );
+      BOOST_REQUIRE_EQUAL( ( get_rex_vote_stake( acct ) + delband["cpu_weight"].as<asset>() + delband["net_weight"].as<asset>() ).get_amount(),
+                           voter["staked"].as<int64_t>() );
+      expected_votes += voter["last_vote_weight"].as_double();
+   }
+   BOOST_TEST_REQUIRE( expected_votes == get_producer_info( "defproducera"_n )["total_votes"].as_double() );
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(rex_maintenance_scheduled_in_rexexec, eosio_system_tester) try {
+   const std::vector<account_name> accounts = { "aliceaccount"_n, "bobbyaccount"_n, "carolaccount"_n, "dannyaccount"_n };
+   account_name alice = accounts[0], bob = accounts[1], carol = accounts[2], danny = accounts[3];
+   setup_rex_accounts( accounts, core_sym::from_string("11100000.0000") );
+   BOOST_REQUIRE_EQUAL( success(), buyrex( alice, core_sym::from_string("11000000.0000") ) );
+   BOOST_REQUIRE_EQUAL( success(), buyrex( carol, core_sym::from_string("500000.0000") ) );
+   BOOST_REQUIRE_EQUAL( success(), buyrex( danny, core_sym::from_string("500000.0000") ) );
+   produce_block( fc::days(5) );
+   produce_blocks( 1 );
+
+   auto setrexmaint = [&]( bool scheduled, uint16_t cpu_loans, uint16_t net_loans, uint16_t sell_orders ) {
+      return push_action( config::system_account_name, "setrexmaint"_n, mvo()
+                          ("scheduled", scheduled)("cpu_loan_budget", cpu_loans)
+                          ("net_loan_budget", net_loans)("sell_order_budget", sell_orders) );
+   };
+   BOOST_REQUIRE_EQUAL( error("missing authority of eosio"),
+                        push_action( alice, "setrexmaint"_n, mvo()("scheduled", true)("cpu_loan_budget", 1)
+                                                                  ("net_loan_budget", 1)("sell_order_budget", 1) ) );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("scheduled maintenance budgets must be positive"), setrexmaint( true, 0, 1, 1 ) );
+   BOOST_REQUIRE_EQUAL( success(), setrexmaint( true, 2, 1, 1 ) );
+
+   // small loans 1 to 4, then loan 5 leaves less than a tenth of the lent tokens unlent, even once its fee is
+   // returned to REX, so the sell orders are queued until loan 5 is closed
+   const asset fee = core_sym::from_string("10.0000");
+   BOOST_REQUIRE_EQUAL( success(), rentcpu( bob, bob, fee ) );
+   BOOST_REQUIRE_EQUAL( success(), rentcpu( bob, bob, fee ) );
+   BOOST_REQUIRE_EQUAL( success(), rentnet( bob, bob, fee ) );
+   BOOST_REQUIRE_EQUAL( success(), rentnet( bob, bob, fee ) );
+   BOOST_REQUIRE_EQUAL( success(), rentcpu( bob, bob, core_sym::from_string("400000.0000") ) );
+   BOOST_REQUIRE_EQUAL( success(), sellrex( carol, get_rex_balance( carol ) ) );
+   BOOST_REQUIRE_EQUAL( success(), sellrex( danny, get_rex_balance( danny ) ) );
+   BOOST_REQUIRE( get_rex_order( carol )["is_open"].as<bool>() );
+   BOOST_REQUIRE( get_rex_order( danny )["is_open"].as<bool>() );
+   produce_block( fc::days(31) );
+   produce_blocks( 1 );
+
+   // REX user actions leave the expired loans to rexexec
+   BOOST_REQUIRE_EQUAL( success(), buyrex( alice, core_sym::from_string("1.0000") ) );
+   for ( uint64_t loan_num = 1; loan_num <= 5; ++loan_num ) {
+      BOOST_REQUIRE( !( loan_num == 3 || loan_num == 4 ? get_net_loan( loan_num ) : get_cpu_loan( loan_num ) ).is_null() );
+   }
+
+   // rexexec stays within each budget, the sell orders wait for loan 5 to return its tokens
+   BOOST_REQUIRE( std::vector<uint16_t>({ 2, 1, 0 }) == get_rexexec_result( bob, 10 ) );
+   BOOST_REQUIRE( get_cpu_loan(1).is_null() );
+   BOOST_REQUIRE( get_cpu_loan(2).is_null() );
+   BOOST_REQUIRE( get_net_loan(3).is_null() );
+   BOOST_REQUIRE( !get_net_loan(4).is_null() );
+   BOOST_REQUIRE( !get_cpu_loan(5).is_null() );
+   BOOST_REQUIRE( get_rex_order( carol )["is_open"].as<bool>() );
+
+   // the max of the call caps every budget
+   BOOST_REQUIRE( std::vector<uint16_t>({ 1, 1, 1 }) == get_rexexec_result( bob, 1 ) );
+   BOOST_REQUIRE( get_net_loan(4).is_null() );
+   BOOST_REQUIRE( get_cpu_loan(5).is_null() );
+   BOOST_REQUIRE( !get_rex_order( carol )["is_open"].as<bool>() );
+   BOOST_REQUIRE( get_rex_order( danny )["is_open"].as<bool>() );
+
+   // REX user actions leave the queued sell orders to rexexec, even once they can be filled
+   BOOST_REQUIRE_EQUAL( success(), buyrex( alice, core_sym::from_string("1.0000") ) );
+   BOOST_REQUIRE( get_rex_order( danny )["is_open"].as<bool>() );
+   BOOST_REQUIRE( std::vector<uint16_t>({ 0, 0, 1 }) == get_rexexec_result( bob, 10 ) );
+   BOOST_REQUIRE( !get_rex_order( danny )["is_open"].as<bool>() );
+
+   // nothing is left to process, so no result is sent
+   BOOST_REQUIRE( get_rexexec_result( bob, 10 ).empty() );
+
+   // back to processing in user actions
+   BOOST_REQUIRE_EQUAL( success(), setrexmaint( false, 2, 2, 2 ) );
+   BOOST_REQUIRE_EQUAL( success(), rentcpu( bob, bob, fee ) );
+   produce_block( fc::days(31) );
+   produce_blocks( 1 );
+   BOOST_REQUIRE_EQUAL( success(), buyrex( alice, core_sym::from_string("1.0000") ) );
+   BOOST_REQUIRE( get_cpu_loan(6).is_null() );
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(rex_loans_share_one_queue, eosio_system_tester) try {
+   const std::vector<account_name> accounts = { "aliceaccount"_n, "bobbyaccount"_n };
+   account_name alice = accounts[0], bob = accounts[1];
+   setup_rex_accounts( accounts, core_sym::from_string("25000.0000") );
+   BOOST_REQUIRE_EQUAL( success(), buyrex( alice, core_sym::from_string("20000.0000") ) );
+
+   const int64_t init_cpu = get_cpu_limit( bob );
+   const int64_t init_net = get_net_limit( bob );
+   const asset   fee      = core_sym::from_string("10.0000");
+   BOOST_REQUIRE_EQUAL( success(), rentcpu( bob, bob, fee ) );
+   BOOST_REQUIRE_EQUAL( success(), rentnet( bob, bob, fee ) );
+   BOOST_REQUIRE_EQUAL( 1,         get_last_cpu_loan()["loan_num"].as_uint64() );
+   BOOST_REQUIRE_EQUAL( 2,         get_last_net_loan()["loan_num"].as_uint64() );
+   BOOST_TEST_REQUIRE( init_cpu < get_cpu_limit( bob ) );
+   BOOST_TEST_REQUIRE( init_net < get_net_limit( bob ) );
+
+   // loan numbers are shared, so a loan is only found through the actions of its own resource
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("loan not found"), fundnetloan( bob, 1, fee ) );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("loan not found"), fundcpuloan( bob, 2, fee ) );
+   BOOST_REQUIRE_EQUAL( success(), fundcpuloan( bob, 1, fee ) );
+   BOOST_REQUIRE_EQUAL( success(), defundcpuloan( bob, 1, fee ) );
+
+   produce_block( fc::days(31) );
+   produce_blocks( 1 );
+   BOOST_REQUIRE_EQUAL( success(), rexexec( alice, 1 ) );
+   BOOST_REQUIRE( get_cpu_loan(1).is_null() );
+   BOOST_REQUIRE( get_net_loan(2).is_null() );
+   BOOST_REQUIRE_EQUAL( init_cpu, get_cpu_limit( bob ) );
+   BOOST_REQUIRE_EQUAL( init_net, get_net_limit( bob ) );
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(legacy_rex_loans_renew_in_place, eosio_system_tester) try {
+   const std::vector<account_name> accounts = { "aliceaccount"_n, "bobbyaccount"_n };
+   account_name alice = accounts[0], bob = accounts[1];
+   setup_rex_accounts( accounts, core_sym::from_string("25000.0000") );
+   BOOST_REQUIRE_EQUAL( success(), buyrex( alice, core_sym::from_string("20000.0000") ) );
+   const int64_t init_alice_cpu = get_cpu_limit( alice );
+   const int64_t init_bob_cpu   = get_cpu_limit( bob );
+   const int64_t init_bob_net   = get_net_limit( bob );
+
+   // the previous contract rents into its cpuloan and netloan tables
+   set_code( config::system_account_name, contracts::util::system_wasm_old() );
+   set_abi(  config::system_account_name, contracts::util::system_abi_old().data() );
+   produce_block();
+   const asset fee = core_sym::from_string("10.0000");
+   BOOST_REQUIRE_EQUAL( success(), rentcpu( bob, bob, fee, core_sym::from_string("20.0000") ) );
+   BOOST_REQUIRE_EQUAL( success(), rentnet( bob, bob, fee, core_sym::from_string("20.0000") ) );
+   BOOST_REQUIRE_EQUAL( success(), rentcpu( alice, alice, fee ) );
+
+   set_code( config::system_account_name, contracts::system_wasm() );
+   set_abi(  config::system_account_name, contracts::system_abi().data() );
+   produce_block();
+
+   auto legacy_loan = [&]( const table_name& table, uint64_t loan_num ) {
+      vector<char> data = get_row_by_account( config::system_account_name, config::system_account_name, table, account_name(loan_num) );
+      return data.empty() ? fc::variant() : abi_ser.binary_to_variant( "rex_loan", data, abi_serializer::create_yield_function(abi_serializer_max_time) );
+   };
+   const fc::variant cpu_loan = legacy_loan( "cpuloan"_n, 1 );
+   const fc::variant net_loan = legacy_loan( "netloan"_n, 2 );
+   BOOST_REQUIRE( !cpu_loan.is_null() );
+   BOOST_REQUIRE( !net_loan.is_null() );
+   BOOST_REQUIRE( !legacy_loan( "cpuloan"_n, 3 ).is_null() );
+   BOOST_REQUIRE_EQUAL( init_bob_cpu + cpu_loan["total_staked"].as<asset>().get_amount(), get_cpu_limit( bob ) );
+   BOOST_REQUIRE_EQUAL( init_bob_net + net_loan["total_staked"].as<asset>().get_amount(), get_net_limit( bob ) );
+
+   // alice processes the expired loans, bob's funded ones renew in place without new rows billed to bob
+   produce_block( fc::days(30) );
+   produce_blocks( 1 );
+   const int64_t bob_ram_usage = control->get_resource_limits_manager().get_account_ram_usage( bob );
+   BOOST_REQUIRE_EQUAL( success(), rexexec( alice, 2 ) );
+   BOOST_REQUIRE_EQUAL( bob_ram_usage, control->get_resource_limits_manager().get_account_ram_usage( bob ) );
+   BOOST_REQUIRE( get_row_by_account( config::system_account_name, config::system_account_name, "rexloans"_n, account_name(1) ).empty() );
+   BOOST_REQUIRE( get_row_by_account( config::system_account_name, config::system_account_name, "rexloans"_n, account_name(2) ).empty() );
+
+   const fc::variant renewed_cpu_loan = legacy_loan( "cpuloan"_n, 1 );
+   const fc::variant renewed_net_loan = legacy_loan( "netloan"_n, 2 );
+   for ( const auto& [loan, renewed] : { std::make_pair( cpu_loan, renewed_cpu_loan ), std::make_pair( net_loan, renewed_net_loan ) } ) {
+      BOOST_REQUIRE( !renewed.is_null() );
+      BOOST_REQUIRE( loan["expiration"].as<time_point>() + fc::days(30) == renewed["expiration"].as<time_point>() );
+      BOOST_REQUIRE_EQUAL( loan["balance"].as<asset>() - fee, renewed["balance"].as<asset>() );
+      BOOST_TEST_REQUIRE( 0 < renewed["total_staked"].as<asset>().get_amount() );
+   }
+
+   // the stake changes of both of bob's loans are applied together, alice's unfunded loan is closed
+   BOOST_REQUIRE_EQUAL( init_bob_cpu + renewed_cpu_loan["total_staked"].as<asset>().get_amount(), get_cpu_limit( bob ) );
+   BOOST_REQUIRE_EQUAL( init_bob_net + renewed_net_loan["total_staked"].as<asset>().get_amount(), get_net_limit( bob ) );
+   BOOST_REQUIRE( legacy_loan( "cpuloan"_n, 3 ).is_null() );
+   BOOST_REQUIRE_EQUAL( init_alice_cpu, get_cpu_limit( alice ) );
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(rex_return_buckets_convert_to_ring, eosio_system_tester) try {
+   constexpr uint32_t dist_interval   = 10 * 60;
+   constexpr uint32_t bucket_interval = 12 * 3600;
+   constexpr uint32_t window          = 30 * 144 * dist_interval;
+   const std::vector<account_name> accounts = { "aliceaccount"_n, "bobbyaccount"_n };
+   account_name alice = accounts[0], bob = accounts[1];
+   setup_rex_accounts( accounts, core_sym::from_string("25000.0000") );
+   BOOST_REQUIRE_EQUAL( success(), buyrex( alice, core_sym::from_string("20000.0000") ) );
+   BOOST_REQUIRE_EQUAL( success(), rentcpu( bob, bob, core_sym::from_string("10.0000") ) );
+
+   // seeds a version 0 row, sorted, with one bucket past the window and two within it
+   const uint32_t head = control->head_block_time().sec_since_epoch();
+   const uint32_t base = head - head % bucket_interval;
+   const time_point_sec expired_time{ base - window - 2 * bucket_interval };
+   const time_point_sec older_time{ base - 40 * bucket_interval };
+   const time_point_sec newer_time{ base - bucket_interval };
+   const int64_t expired_rate = 100, older_rate = 200, newer_rate = 300;
+   auto bucket = []( const time_point_sec& t, int64_t rate ) { return mvo()("first", t)("second", rate); };
+   set_row_by_account( config::system_account_name, config::system_account_name, "retbuckets"_n, name(),
+                       abi_ser.variant_to_binary( "rex_return_buckets", mvo()
+                          ("version", 0)
+                          ("return_buckets", fc::variants{ bucket( expired_time, expired_rate ),
+                                                           bucket( older_time, older_rate ),
+                                                           bucket( newer_time, newer_rate ) }),
+                          abi_serializer::create_yield_function(abi_serializer_max_time) ) );
+
+   mvo pool( get_rex_return_pool().get_object() );
+   const time_point_sec last_dist_time = pool["last_dist_time"].as<time_point_sec>();
+   const int64_t        proceeds       = 1'000'000;
+   pool("oldest_bucket_time", expired_time)
+       ("pending_bucket_time", time_point_sec::maximum())
+       ("pending_bucket_proceeds", 0)
+       ("current_rate_of_increase", expired_rate + older_rate + newer_rate)
+       ("proceeds", proceeds);
+   set_row_by_account( config::system_account_name, config::system_account_name, "rexretpool"_n, name(),
+                       abi_ser.variant_to_binary( "rex_return_pool", pool, abi_serializer::create_yield_function(abi_serializer_max_time) ) );
+
+   produce_block( fc::seconds(dist_interval) );
+   produce_blocks( 1 );
+   const asset init_lendable = get_rex_pool()["total_lendable"].as<asset>();
+   BOOST_REQUIRE_EQUAL( success(), rexexec( bob, 1 ) );
+
+   // the first update converts the row, each remaining bucket is in the slot of its time
+   const fc::variant buckets = get_rex_return_buckets();
+   BOOST_REQUIRE_EQUAL( 1,  buckets["version"].as<uint32_t>() );
+   BOOST_REQUIRE_EQUAL( 60, buckets["return_buckets"].get_array().size() );
+   BOOST_REQUIRE_EQUAL( 2,  get_rex_return_bucket_count() );
+   auto slot = [&]( const time_point_sec& t ) { return buckets["return_buckets"].get_array()[ t.sec_since_epoch() / bucket_interval % 60 ]; };
+   BOOST_REQUIRE_EQUAL( older_time.sec_since_epoch(), slot( older_time )["first"].as<time_point_sec>().sec_since_epoch() );
+   BOOST_REQUIRE_EQUAL( older_rate,                   slot( older_time )["second"].as<int64_t>() );
+   BOOST_REQUIRE_EQUAL( newer_time.sec_since_epoch(), slot( newer_time )["first"].as<time_point_sec>().sec_since_epoch() );
+   BOOST_REQUIRE_EQUAL( newer_rate,                   slot( newer_time )["second"].as<int64_t>() );
+   BOOST_REQUIRE_EQUAL( 0,                            slot( expired_time )["first"].as<time_point_sec>().sec_since_epoch() );
+
+   // the expired bucket leaves the rate, and the proceeds it was charged past the window are returned
+   const fc::variant return_pool = get_rex_return_pool();
+   const uint32_t effective_time = return_pool["last_dist_time"].as<time_point_sec>().sec_since_epoch();
+   const int64_t  elapsed        = ( effective_time - last_dist_time.sec_since_epoch() ) / dist_interval;
+   const int64_t  overtime       = ( effective_time - expired_time.sec_since_epoch() - window ) / dist_interval;
+   const int64_t  change         = ( expired_rate + older_rate + newer_rate ) * elapsed - expired_rate * overtime;
+   BOOST_REQUIRE_EQUAL( older_time.sec_since_epoch(), return_pool["oldest_bucket_time"].as<time_point_sec>().sec_since_epoch() );
+   BOOST_REQUIRE_EQUAL( older_rate + newer_rate,      return_pool["current_rate_of_increase"].as<int64_t>() );
+   BOOST_REQUIRE_EQUAL( proceeds - change,            return_pool["proceeds"].as<int64_t>() );
+   BOOST_REQUIRE_EQUAL( init_lendable.get_amount() + std::max<int64_t>( change, 0 ),
+                        get_rex_pool()["total_lendable"].as<asset>().get_amount() );
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_CASE(vote_weight_factors_match_formula) {
+   BOOST_REQUIRE_EQUAL( 31u, eosiosystem::vote_weight_factors.size() );
+   for( size_t n = 0; n < eosiosystem::vote_weight_factors.size(); ++n ) {
+      const double percent_voted = double(n) / 30;
+      const double expected = (sin(M_PI * percent_voted - M_PI_2) + 1.0) / 2.0;
+      uint64_t expected_bits, table_bits;
+      std::memcpy( &expected_bits, &expected, sizeof(expected) );
+      std::memcpy( &table_bits, &eosiosystem::vote_weight_factors[n], sizeof(table_bits) );
+      BOOST_TEST_INFO( "producers voted: " << n );
+      BOOST_REQUIRE_EQUAL( expected_bits, table_bits );
+   }
+}
+
 BOOST_AUTO_TEST_SUITE_END()